@@ -0,0 +1,358 @@
+// Copyright (C) 2011 David C. Haws
+
+//This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// See LICENSE
+
+// David Haws
+// www.davidhaws.net
+// https://github.com/dchaws
+
+// This program times tarjan, getMinCycles, getAllPaths and cycleGenerator on
+// synthetic graphs of a few sizes and prints one CSV line per run:
+//
+// generator,nodes,edges,algorithm,seconds,peak_rss_kb,allocations,alloc_bytes,result,status
+//
+// The generators are
+//   erdos       Every ordered pair is an edge with probability 3/n.
+//   dagback     A random DAG with 3 edges per node on average plus n/20 edges
+//               going back against its order.
+//   bn          Every node gets up to 3 parents chosen at random, like the graphs
+//               an integer program for Bayesian networks proposes.
+//   tournament  Every pair of nodes has one edge, in a random direction.
+// Every run is done in its own process, so peak_rss_kb (from getrusage) is the peak of
+// that run, graph included. allocations and alloc_bytes count the calls to operator new
+// made by the algorithm alone. result is what the algorithm found: the number of
+// components, cycles or paths. A run that takes longer than the time limit is killed
+// and reported with status timeout.
+// Options: -q only runs the smallest size, -s <seed> seeds the generators, -l <seconds>
+// sets the time limit (default 60), -g <generator> and -a <algorithm> only run those.
+
+// make bench
+// ./bench > results.csv
+// ./bench -q -g tournament
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <new>
+#include "graphalg.h"
+
+using namespace std;
+
+static atomic <long long> numAllocations(0);
+static atomic <long long> allocatedBytes(0);
+
+// The memory comes from malloc and goes back through free. Both are behind
+// functions that are not inlined, so the compiler does not see operator new paired
+// with free and warn about it.
+__attribute__((noinline)) void *benchMalloc(size_t size)
+{
+    return malloc(size == 0 ? 1 : size);
+}
+
+__attribute__((noinline)) void benchFree(void *ptr)
+{
+    free(ptr);
+}
+
+void *operator new(size_t size)
+{
+    numAllocations.fetch_add(1,memory_order_relaxed);
+    allocatedBytes.fetch_add(size,memory_order_relaxed);
+    void *ptr = benchMalloc(size);
+    if (ptr == NULL)
+    {
+        throw bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    benchFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    benchFree(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    benchFree(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    benchFree(ptr);
+}
+
+const char *generatorNames[] = {"erdos", "dagback", "bn", "tournament"};
+const char *algorithmNames[] = {"tarjan", "getMinCycles", "getAllPaths", "cycleGenerator"};
+const int numGenerators = 4;
+const int numAlgorithms = 4;
+
+// The longest cycles cycleGenerator is asked for.
+const int benchCycleLengthMax = 5;
+
+// Fills edges with the graph generator makes on numNodes nodes.
+void generateGraph(int generator, int numNodes, unsigned seed, vector <pair <int,int> > &edges)
+{
+    mt19937 rng(seed * 7919 + numNodes);
+    edges.clear();
+    if (generator == 0) // erdos
+    {
+        // Geometric skips between edges, so this is O(n + m) and not O(n^2).
+        double p = min(1.0,3.0 / numNodes);
+        geometric_distribution <long long> skip(p);
+        long long numPairs = (long long)numNodes * numNodes;
+        for (long long k=skip(rng);k<numPairs;k+=1+skip(rng))
+        {
+            int i = (int)(k / numNodes);
+            int j = (int)(k % numNodes);
+            if (i != j)
+            {
+                edges.push_back(pair <int,int> (i,j));
+            }
+        }
+    }
+    else if (generator == 1) // dagback
+    {
+        vector <int> order(numNodes);
+        for (int i=0;i<numNodes;i++)
+        {
+            order[i] = i;
+        }
+        shuffle(order.begin(),order.end(),rng);
+        uniform_int_distribution <int> anyNode(0,numNodes-1);
+        for (int k=0;k<3*numNodes;k++)
+        {
+            int i = anyNode(rng);
+            int j = anyNode(rng);
+            if (i != j)
+            {
+                edges.push_back(pair <int,int> (order[min(i,j)],order[max(i,j)]));
+            }
+        }
+        for (int k=0;k<numNodes/20;k++)
+        {
+            int i = anyNode(rng);
+            int j = anyNode(rng);
+            if (i != j)
+            {
+                edges.push_back(pair <int,int> (order[max(i,j)],order[min(i,j)]));
+            }
+        }
+    }
+    else if (generator == 2) // bn
+    {
+        uniform_int_distribution <int> anyNode(0,numNodes-1);
+        uniform_int_distribution <int> numParents(0,3);
+        for (int j=0;j<numNodes;j++)
+        {
+            int k = numParents(rng);
+            for (int p=0;p<k;p++)
+            {
+                int i = anyNode(rng);
+                if (i != j)
+                {
+                    edges.push_back(pair <int,int> (i,j));
+                }
+            }
+        }
+    }
+    else // tournament
+    {
+        for (int i=0;i<numNodes;i++)
+        {
+            for (int j=i+1;j<numNodes;j++)
+            {
+                if ((rng() & 1) == 0)
+                {
+                    edges.push_back(pair <int,int> (i,j));
+                }
+                else
+                {
+                    edges.push_back(pair <int,int> (j,i));
+                }
+            }
+        }
+    }
+}
+
+// The sizes each algorithm is run on. getAllPaths lists every path, so it only gets
+// small graphs. getMinCycles lists a cycle for every edge outside its DFS trees, each
+// as long as the tree is deep, so it gets fewer nodes than tarjan. Tournaments are
+// dense so they get fewer nodes.
+vector <int> benchSizes(int generator, int algorithm)
+{
+    int sizes[4][3] = {{1000, 10000, 100000},  // tarjan
+                       {1000, 3000, 10000},    // getMinCycles
+                       {12, 16, 20},           // getAllPaths
+                       {100, 1000, 10000}};    // cycleGenerator
+    int tournamentSizes[4][3] = {{100, 1000, 3000},
+                                 {50, 200, 500},
+                                 {8, 10, 12},
+                                 {16, 24, 32}};
+    if (generator == 3)
+    {
+        return vector <int> (tournamentSizes[algorithm],tournamentSizes[algorithm]+3);
+    }
+    return vector <int> (sizes[algorithm],sizes[algorithm]+3);
+}
+
+// Runs algorithm on g and returns what it found.
+long long runAlgorithm(int algorithm, const csrGraph &g)
+{
+    if (algorithm == 0)
+    {
+        return tarjan(g).size();
+    }
+    if (algorithm == 1)
+    {
+        return getMinCycles(g).size();
+    }
+    if (algorithm == 2)
+    {
+        return getAllPaths(g,0,g.getNumNodes()-1,1).size();
+    }
+    cycleGenerator myCycleGen(g);
+    myCycleGen.setCycleLengthMin(2);
+    myCycleGen.setCycleLengthMax(benchCycleLengthMax);
+    long long numCycles = 0;
+    list <int> myCycle = myCycleGen.nextCycle();
+    while (myCycle.size() != 0 && myCycle.size() <= benchCycleLengthMax)
+    {
+        numCycles++;
+        myCycle = myCycleGen.nextCycle();
+    }
+    return numCycles;
+}
+
+// Runs one benchmark in a child process and prints its line.
+void runBenchmark(int generator, int algorithm, int numNodes, unsigned seed, int timeLimit)
+{
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        alarm(timeLimit);
+        vector <pair <int,int> > edges;
+        generateGraph(generator,numNodes,seed,edges);
+        csrGraph g(numNodes,edges);
+        edges = vector <pair <int,int> > ();
+
+        numAllocations = 0;
+        allocatedBytes = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        long long result = runAlgorithm(algorithm,g);
+        double seconds = chrono::duration <double> (chrono::steady_clock::now() - start).count();
+        long long allocations = numAllocations;
+        long long bytes = allocatedBytes;
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF,&usage);
+        printf("%s,%d,%d,%s,%.6f,%ld,%lld,%lld,%lld,ok\n",generatorNames[generator],numNodes,
+               g.getNumEdges(),algorithmNames[algorithm],seconds,usage.ru_maxrss,allocations,bytes,result);
+        fflush(stdout);
+        _exit(0);
+    }
+
+    int status = 0;
+    if (pid < 0 || waitpid(pid,&status,0) != pid)
+    {
+        printf("%s,%d,,%s,,,,,,failed\n",generatorNames[generator],numNodes,algorithmNames[algorithm]);
+    }
+    else if (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM)
+    {
+        printf("%s,%d,,%s,%d,,,,,timeout\n",generatorNames[generator],numNodes,algorithmNames[algorithm],timeLimit);
+    }
+    else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+    {
+        printf("%s,%d,,%s,,,,,,failed\n",generatorNames[generator],numNodes,algorithmNames[algorithm]);
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    int quick = 0;
+    unsigned seed = 1;
+    int timeLimit = 60;
+    const char *onlyGenerator = NULL;
+    const char *onlyAlgorithm = NULL;
+
+    for (int i=1;i<argc;i++)
+    {
+        if (strcmp(argv[i],"-q") == 0)
+        {
+            quick = 1;
+        }
+        else if (strcmp(argv[i],"-s") == 0 && i+1 < argc)
+        {
+            seed = (unsigned)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i],"-l") == 0 && i+1 < argc)
+        {
+            timeLimit = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i],"-g") == 0 && i+1 < argc)
+        {
+            onlyGenerator = argv[++i];
+        }
+        else if (strcmp(argv[i],"-a") == 0 && i+1 < argc)
+        {
+            onlyAlgorithm = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr,"Usage: %s [-q] [-s seed] [-l seconds] [-g generator] [-a algorithm]\n",argv[0]);
+            return 1;
+        }
+    }
+
+    printf("generator,nodes,edges,algorithm,seconds,peak_rss_kb,allocations,alloc_bytes,result,status\n");
+    for (int generator=0;generator<numGenerators;generator++)
+    {
+        if (onlyGenerator != NULL && strcmp(onlyGenerator,generatorNames[generator]) != 0)
+        {
+            continue;
+        }
+        for (int algorithm=0;algorithm<numAlgorithms;algorithm++)
+        {
+            if (onlyAlgorithm != NULL && strcmp(onlyAlgorithm,algorithmNames[algorithm]) != 0)
+            {
+                continue;
+            }
+            vector <int> sizes = benchSizes(generator,algorithm);
+            for (int k=0;k<sizes.size() && (quick == 0 || k == 0);k++)
+            {
+                runBenchmark(generator,algorithm,sizes[k],seed,timeLimit);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,469 @@
+// Copyright (C) 2011 David C. Haws
+
+//This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// See LICENSE
+
+// David Haws
+// www.davidhaws.net
+// https://github.com/dchaws
+
+// This program checks the faster algorithms against the plain ones on random
+// graphs. It prints one line per check and returns 1 if any of them failed.
+
+// make check
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <random>
+#include "graphalg.h"
+
+using namespace std;
+
+// Returns 1 if the nodes are split into the same parts by compOne and compTwo.
+int samePartition(const vector <int> &compOne, const vector <int> &compTwo)
+{
+    map <int,int> oneToTwo, twoToOne;
+    for (int v=0;v<compOne.size();v++)
+    {
+        if (oneToTwo.count(compOne[v]) == 0 && twoToOne.count(compTwo[v]) == 0)
+        {
+            oneToTwo[compOne[v]] = compTwo[v];
+            twoToOne[compTwo[v]] = compOne[v];
+        }
+        else if (oneToTwo.count(compOne[v]) == 0 || oneToTwo[compOne[v]] != compTwo[v])
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Returns 1 if dynamicSCC has the components of edges, listed in a reverse
+// topological order.
+int dynamicSCCCorrect(dynamicSCC &dyn, int numNodes, const set <pair <int,int> > &edges)
+{
+    csrGraph g(numNodes,vector <pair <int,int> > (edges.begin(),edges.end()));
+    vector <int> compId(numNodes);
+    int numComps = tarjanComponents(g,compId.data());
+    if (dyn.numComponents() != numComps)
+    {
+        return 0;
+    }
+
+    list <set <int> > comps = dyn.components();
+    if (comps.size() != numComps)
+    {
+        return 0;
+    }
+    vector <int> place(numNodes,-1);
+    vector <int> dynComp(numNodes);
+    int k = 0;
+    for (list <set <int> >::iterator lit=comps.begin();lit!=comps.end();lit++,k++)
+    {
+        for (set <int>::iterator sit=lit->begin();sit!=lit->end();sit++)
+        {
+            place[*sit] = k;
+            dynComp[*sit] = dyn.getComponent(*sit);
+        }
+    }
+    for (int v=0;v<numNodes;v++)
+    {
+        if (place[v] == -1)
+        {
+            return 0;
+        }
+    }
+    for (set <pair <int,int> >::const_iterator eit=edges.begin();eit!=edges.end();eit++)
+    {
+        if (place[eit->first] < place[eit->second])
+        {
+            return 0;
+        }
+    }
+    return samePartition(compId,place) == 1 && samePartition(compId,dynComp) == 1 ? 1 : 0;
+}
+
+// Random addEdge and removeEdge calls, checked after each one against tarjanComponents.
+int checkDynamicSCC()
+{
+    mt19937 rng(12);
+    int failed = 0;
+    for (int run=0;run<200 && failed==0;run++)
+    {
+        int numNodes = 2 + rng() % 12;
+        dynamicSCC dyn;
+        int **adjMat = allocateAdjMat(numNodes);
+        dyn.copyAdjMatInt(adjMat,numNodes);
+        deleteAdjMat(adjMat,numNodes);
+        set <pair <int,int> > edges;
+        for (int step=0;step<100 && failed==0;step++)
+        {
+            int a = rng() % numNodes;
+            int b = rng() % numNodes;
+            if (a == b)
+            {
+                continue;
+            }
+            if (rng() % 3 == 0)
+            {
+                dyn.removeEdge(a,b);
+                edges.erase(pair <int,int> (a,b));
+            }
+            else
+            {
+                dyn.addEdge(a,b);
+                edges.insert(pair <int,int> (a,b));
+            }
+            failed = dynamicSCCCorrect(dyn,numNodes,edges) == 1 ? 0 : 1;
+        }
+    }
+    return failed;
+}
+
+// A sequence on 8 nodes after which adding 7->5 must merge 5 and 7. Merges used to
+// give their labels back out of order, so 7 ended up before 5.
+int checkDynamicSCCMerge()
+{
+    const char *ops = "-72+30-20+42+46-37+47-65-45+46-34+40+34-37+32+20+57+47+63+75";
+    dynamicSCC dyn;
+    int **adjMat = allocateAdjMat(8);
+    dyn.copyAdjMatInt(adjMat,8);
+    deleteAdjMat(adjMat,8);
+    set <pair <int,int> > edges;
+    for (int k=0;ops[k]!='\0';k+=3)
+    {
+        int a = ops[k+1] - '0';
+        int b = ops[k+2] - '0';
+        if (ops[k] == '+')
+        {
+            dyn.addEdge(a,b);
+            edges.insert(pair <int,int> (a,b));
+        }
+        else
+        {
+            dyn.removeEdge(a,b);
+            edges.erase(pair <int,int> (a,b));
+        }
+        if (dynamicSCCCorrect(dyn,8,edges) == 0)
+        {
+            return 1;
+        }
+    }
+    return dyn.getComponent(5) == dyn.getComponent(7) ? 0 : 1;
+}
+
+// parallelComponents against tarjanComponents on random graphs, some of them big
+// enough for the forward-backward search, with 2 to 8 threads.
+int checkParallelComponents()
+{
+    mt19937 rng(4);
+    for (int run=0;run<40;run++)
+    {
+        int numNodes = run % 2 == 0 ? 1 + rng() % 2000 : 5000 + rng() % 50000;
+        int edgesPerNode = 1 + rng() % 3;
+        vector <pair <int,int> > edges;
+        for (int k=0;k<edgesPerNode*numNodes;k++)
+        {
+            edges.push_back(pair <int,int> (rng() % numNodes,rng() % numNodes));
+        }
+        csrGraph g(numNodes,edges);
+        vector <int> compId(numNodes), parallelCompId(numNodes);
+        int numComps = tarjanComponents(g,compId.data());
+        int numThreads = 2 + run % 7;
+        if (parallelComponents(g,parallelCompId.data(),numThreads,0) != numComps ||
+            samePartition(compId,parallelCompId) == 0)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Adds every cycle that starts with path and has path[0] as its smallest node to
+// cycles, as its nodes in order. Self loops are left out.
+void bruteForceCycles(const csrGraph &g, vector <int> &path, vector <char> &onPath, set <vector <int> > &cycles)
+{
+    int v = path.back();
+    for (const int *nit=g.outBegin(v);nit!=g.outEnd(v);nit++)
+    {
+        if (*nit == path[0] && path.size() > 1)
+        {
+            cycles.insert(path);
+        }
+        else if (*nit > path[0] && onPath[*nit] == 0)
+        {
+            path.push_back(*nit);
+            onPath[*nit] = 1;
+            bruteForceCycles(g,path,onPath,cycles);
+            onPath[*nit] = 0;
+            path.pop_back();
+        }
+    }
+}
+
+// All cycles of g, found by trying every path.
+set <vector <int> > bruteForceCycles(const csrGraph &g)
+{
+    set <vector <int> > cycles;
+    vector <char> onPath(g.getNumNodes(),0);
+    for (int s=0;s<g.getNumNodes();s++)
+    {
+        vector <int> path(1,s);
+        onPath[s] = 1;
+        bruteForceCycles(g,path,onPath,cycles);
+        onPath[s] = 0;
+    }
+    return cycles;
+}
+
+// A random graph on numNodes nodes with each edge, self loops included, there with
+// probability density.
+csrGraph randomGraph(mt19937 &rng, int numNodes, double density)
+{
+    uniform_real_distribution <double> coin(0.0,1.0);
+    vector <pair <int,int> > edges;
+    for (int i=0;i<numNodes;i++)
+    {
+        for (int j=0;j<numNodes;j++)
+        {
+            if (coin(rng) < density)
+            {
+                edges.push_back(pair <int,int> (i,j));
+            }
+        }
+    }
+    return csrGraph(numNodes,edges);
+}
+
+// johnsonCycleGenerator against all cycles found by trying every path, with random
+// length limits and with and without setHashBiDirectedCycles. Then a DAG of 20000
+// nodes with long paths and one 2-cycle, where each start node used to search
+// everything above it.
+int checkJohnsonCycleGenerator()
+{
+    mt19937 rng(5);
+    for (int run=0;run<400;run++)
+    {
+        int numNodes = 1 + rng() % 9;
+        csrGraph g = randomGraph(rng,numNodes,0.1 + 0.05 * (rng() % 8));
+        int lengthMin = 1 + rng() % 3;
+        int lengthMax = rng() % 2 == 0 ? -1 : 2 + rng() % numNodes;
+        int hashBiDirected = rng() % 2;
+
+        set <vector <int> > expected;
+        set <vector <int> > allCycles = bruteForceCycles(g);
+        for (set <vector <int> >::iterator sit=allCycles.begin();sit!=allCycles.end();sit++)
+        {
+            int length = sit->size();
+            if (length < lengthMin || (lengthMax != -1 && length > lengthMax))
+            {
+                continue;
+            }
+            if (hashBiDirected == 1 && length > 2 && (*sit)[1] > (*sit)[length-1])
+            {
+                vector <int> reverseCycle(1,(*sit)[0]);
+                reverseCycle.insert(reverseCycle.end(),sit->rbegin(),sit->rend()-1);
+                if (allCycles.count(reverseCycle) == 1)
+                {
+                    continue;
+                }
+            }
+            expected.insert(*sit);
+        }
+
+        johnsonCycleGenerator gen(g);
+        gen.setCycleLengthMin(lengthMin);
+        gen.setCycleLengthMax(lengthMax);
+        gen.setHashBiDirectedCycles(hashBiDirected);
+        set <vector <int> > found;
+        while (gen.findCycle() == 1)
+        {
+            if (found.insert(gen.currentCycle()).second == false)
+            {
+                return 1;
+            }
+        }
+        if (found != expected)
+        {
+            return 1;
+        }
+    }
+
+    int numNodes = 20000;
+    vector <pair <int,int> > edges;
+    for (int k=0;k<3*numNodes;k++)
+    {
+        int a = rng() % (numNodes-2);
+        int b = a + 1 + rng() % 8;
+        if (b < numNodes-2)
+        {
+            edges.push_back(pair <int,int> (a,b));
+        }
+    }
+    edges.push_back(pair <int,int> (numNodes-2,numNodes-1));
+    edges.push_back(pair <int,int> (numNodes-1,numNodes-2));
+    johnsonCycleGenerator gen(csrGraph(numNodes,edges));
+    int numCycles = 0;
+    while (gen.findCycle() == 1)
+    {
+        numCycles++;
+    }
+    return numCycles == 1 ? 0 : 1;
+}
+
+// countCyclesByLength against all cycles found by trying every path. The graphs of
+// the odd runs have a cycle through every node, so their one component is too big
+// for countCyclesSubsets and goes through johnsonCycleGenerator.
+int checkCountCyclesByLength()
+{
+    mt19937 rng(14);
+    for (int run=0;run<300;run++)
+    {
+        int numNodes = run % 2 == 0 ? 1 + rng() % 14 : 17 + rng() % 8;
+        csrGraph g = randomGraph(rng,numNodes,(1.0 + (rng() % 4) * 0.5) / numNodes);
+        if (run % 2 == 1)
+        {
+            vector <pair <int,int> > edges;
+            for (int i=0;i<numNodes;i++)
+            {
+                for (const int *nit=g.outBegin(i);nit!=g.outEnd(i);nit++)
+                {
+                    edges.push_back(pair <int,int> (i,*nit));
+                }
+                edges.push_back(pair <int,int> (i,(i+1) % numNodes));
+            }
+            g.fromEdges(numNodes,edges);
+        }
+        int maxLength = rng() % 2 == 0 ? -1 : 2 + rng() % numNodes;
+
+        vector <long long> counts = countCyclesByLength(g,maxLength);
+        int maxIndex = maxLength == -1 || maxLength > numNodes ? numNodes : maxLength;
+        vector <long long> expected(maxIndex+1,0);
+        set <vector <int> > allCycles = bruteForceCycles(g);
+        for (set <vector <int> >::iterator sit=allCycles.begin();sit!=allCycles.end();sit++)
+        {
+            if (sit->size() <= maxIndex)
+            {
+                expected[sit->size()]++;
+            }
+        }
+        if (counts != expected)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// separateCycles against the k lightest of all cycles, found by trying every path,
+// that weigh at most 1 - minViolation. Half the runs give x in quarters, so there
+// are ties and cycles that weigh exactly 1 - minViolation. Since it is not said
+// which of the ties with the k-th are returned, the weights are compared, and each
+// cycle returned must be a different cycle of that weight.
+int checkSeparateCycles()
+{
+    mt19937 rng(11);
+    uniform_real_distribution <double> coin(0.0,1.0);
+    violatedCycleLighter lighter;
+    for (int run=0;run<500;run++)
+    {
+        int numNodes = 5 + rng() % 5;
+        csrGraph g = randomGraph(rng,numNodes,0.2 + 0.1 * (rng() % 4));
+        vector <double> x(g.getNumEdges());
+        for (int e=0;e<x.size();e++)
+        {
+            x[e] = run % 2 == 0 ? 0.25 * (rng() % 6) : coin(rng);
+        }
+        int k = run % 3 == 0 ? 0 : 1 + rng() % 5;
+        double minViolation = run % 2 == 0 ? 0.25 : 1e-6;
+
+        // The weights are added up along the cycle from its smallest node, like
+        // separateCycles does, so they come out exactly the same.
+        vector <violatedCycle> expected;
+        map <vector <int>,double> weightOf;
+        set <vector <int> > allCycles = bruteForceCycles(g);
+        for (set <vector <int> >::iterator sit=allCycles.begin();sit!=allCycles.end();sit++)
+        {
+            violatedCycle newCycle;
+            newCycle.cycle = *sit;
+            newCycle.weight = 0.0;
+            for (int i=0;i<sit->size();i++)
+            {
+                int a = (*sit)[i];
+                int b = (*sit)[(i+1) % sit->size()];
+                int e = g.outOffset(a) + (lower_bound(g.outBegin(a),g.outEnd(a),b) - g.outBegin(a));
+                newCycle.weight += x[e] < 1.0 ? 1.0 - x[e] : 0.0;
+            }
+            newCycle.violation = 1.0 - newCycle.weight;
+            weightOf[newCycle.cycle] = newCycle.weight;
+            if (newCycle.weight <= 1.0 - minViolation)
+            {
+                expected.push_back(newCycle);
+            }
+        }
+        sort(expected.begin(),expected.end(),lighter);
+        if (k > 0 && expected.size() > k)
+        {
+            expected.resize(k);
+        }
+
+        vector <violatedCycle> found = separateCycles(g,x.data(),k,minViolation);
+        if (found.size() != expected.size())
+        {
+            return 1;
+        }
+        set <vector <int> > foundCycles;
+        for (int i=0;i<found.size();i++)
+        {
+            if (found[i].weight != expected[i].weight || weightOf.count(found[i].cycle) == 0 ||
+                weightOf[found[i].cycle] != found[i].weight || foundCycles.insert(found[i].cycle).second == false)
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+int main (int argc, char *argv[])
+{
+    int failed = 0;
+    int result = checkDynamicSCCMerge();
+    cout << "dynamicSCC merge of 5 and 7: " << (result == 0 ? "ok" : "FAILED") << endl;
+    failed |= result;
+
+    result = checkDynamicSCC();
+    cout << "dynamicSCC against tarjanComponents: " << (result == 0 ? "ok" : "FAILED") << endl;
+    failed |= result;
+
+    result = checkParallelComponents();
+    cout << "parallelComponents against tarjanComponents: " << (result == 0 ? "ok" : "FAILED") << endl;
+    failed |= result;
+
+    result = checkJohnsonCycleGenerator();
+    cout << "johnsonCycleGenerator against all paths: " << (result == 0 ? "ok" : "FAILED") << endl;
+    failed |= result;
+
+    result = checkCountCyclesByLength();
+    cout << "countCyclesByLength against all paths: " << (result == 0 ? "ok" : "FAILED") << endl;
+    failed |= result;
+
+    result = checkSeparateCycles();
+    cout << "separateCycles against all paths: " << (result == 0 ? "ok" : "FAILED") << endl;
+    failed |= result;
+
+    return failed;
+}
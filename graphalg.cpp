@@ -32,6 +32,11 @@
 
 
 #include "graphalg.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <limits.h>
 
 using namespace std;
 
@@ -81,21 +86,72 @@ int getPathDFS(int **adjMat, int numNodes, int curNode, int endNode, list <int>
     return foundEndNode;
 }
 
-list <list <int> > getAllPaths(int **adjMat, int numNodes, int a, int b, int directed)
+// Same as above, but on a csrGraph. Uses an explicit stack and parent pointers
+// and stops as soon as b is found. Returns the same path as the matrix version.
+list <int> getPath(const csrGraph &g, int a, int b, int directed)
 {
-    list <list <int> > retPaths;
-    list <int> curPath;
-    set <int> markedNodes;
+    list <int> retPath;
     if (a == b)
     {
-        curPath.push_back(a);
-        retPaths.push_back(curPath);
-        return retPaths;
+        return retPath;
     }
-    curPath.push_front(a);
-    getAllPathsDFS(adjMat,numNodes,a,b,curPath,retPaths,markedNodes,directed);
 
-    return retPaths;
+    int numNodes = g.getNumNodes();
+    int *parent = new int[numNodes];
+    const int **nextNeighbor = new const int *[numNodes];
+    for (int i=0;i<numNodes;i++)
+    {
+        parent[i] = -2; // -2 means not marked
+    }
+
+    vector <int> myStack;
+    myStack.push_back(a);
+    parent[a] = -1;
+    nextNeighbor[a] = g.outBegin(a);
+    int found = 0;
+    while (myStack.size() != 0 && found == 0)
+    {
+        int curNode = myStack.back();
+        if (nextNeighbor[curNode] == g.outEnd(curNode))
+        {
+            myStack.pop_back();
+            continue;
+        }
+        int i = *(nextNeighbor[curNode]);
+        nextNeighbor[curNode]++;
+        // Only go to i if edge and i not marked
+        if (parent[i] == -2 && (directed == 1 || g.hasEdge(i,curNode) == 1))
+        {
+            parent[i] = curNode;
+            if (i == b)
+            {
+                found = 1;
+            }
+            else
+            {
+                nextNeighbor[i] = g.outBegin(i);
+                myStack.push_back(i);
+            }
+        }
+    }
+
+    if (found == 1)
+    {
+        for (int curNode=b;curNode!=-1;curNode=parent[curNode])
+        {
+            retPath.push_front(curNode);
+        }
+    }
+
+    delete [] parent;
+    delete [] nextNeighbor;
+    return retPath;
+}
+
+list <list <int> > getAllPaths(int **adjMat, int numNodes, int a, int b, int directed)
+{
+    csrGraph g(adjMat,numNodes);
+    return getAllPaths(g,a,b,directed);
 }
 
 // Internal DFS function for getPath.
@@ -134,46 +190,127 @@ int getAllPathsDFS(int **adjMat, int numNodes, int curNode, int endNode, list <i
 
     // Remove the mark.
     markedNodes.erase(markedNodes.find(curNode));
+    return 0;
 }
 
+list <list <int> > getAllPaths(const csrGraph &g, int a, int b, int directed)
+{
+    list <list <int> > retPaths;
+    visitAllPaths(g,a,b,directed,-1,[&](const int *path, int length)
+    {
+        retPaths.push_back(list <int> (path,path+length));
+        return 1;
+    });
+    return retPaths;
+}
 
-
-// This returns a list of list of strongly connected components.
-list <set <int> > tarjan (int **adjMatrix, int numNodes)
+long long visitAllPaths(const csrGraph &g, int a, int b, int directed, int maxLength, const function <int (const int *, int)> &visit)
 {
-    // Allocate matrix for the index of each node.
-    // Allocate matrix for the lowlink of each node.
-    int *nodeIndex   = new int[numNodes];
-    int *nodeLowlink = new int[numNodes];
-    for (int i=0;i<numNodes;i++)
+    int numNodes = g.getNumNodes();
+    vector <int> path(1,a);
+    if (a == b)
     {
-        // Initialize the values
-        nodeIndex[i] = -1; //-1 means undef
-        nodeLowlink[i] = -1; //-1 means undef
+        if (maxLength == -1 || maxLength >= 1)
+        {
+            visit(path.data(),1);
+            return 1;
+        }
+        return 0;
     }
-    
-    list <set <int> > strongConComps; // This will store the strongly connected components we find.
 
-    int index=0;
-    list <int> myQueue;
-    set <int> myQueueContents;
-    for (int i=0;i<numNodes;i++)
+    // distToEnd[v] is the fewest edges from v to b, -1 if b can not be reached.
+    // Undirected edges go both ways, so for directed = 0 the out-edges will do.
+    csrGraph reverseCopy;
+    const csrGraph *backward = &g;
+    if (directed == 1 && g.hasReverse() == 0)
+    {
+        reverseCopy = g;
+        reverseCopy.buildReverse();
+        backward = &reverseCopy;
+    }
+    vector <int> distToEnd(numNodes,-1);
+    vector <int> queue(1,b);
+    distToEnd[b] = 0;
+    for (int pos=0;pos<queue.size();pos++)
     {
-        if (nodeIndex[i] == -1)
+        int v = queue[pos];
+        const int *nit = directed == 1 ? backward->inBegin(v) : g.outBegin(v);
+        const int *nend = directed == 1 ? backward->inEnd(v) : g.outEnd(v);
+        for (;nit!=nend;nit++)
         {
-            strongConnect(adjMatrix, nodeIndex, nodeLowlink, numNodes, i, index, myQueue, myQueueContents, strongConComps);
+            if (distToEnd[*nit] == -1 && (directed == 1 || g.hasEdge(*nit,v) == 1))
+            {
+                distToEnd[*nit] = distToEnd[v] + 1;
+                queue.push_back(*nit);
+            }
         }
     }
+    vector <int> ().swap(queue);
+    reverseCopy.clear();
+    if (distToEnd[a] == -1 || (maxLength != -1 && distToEnd[a] + 1 > maxLength))
+    {
+        return 0;
+    }
 
-    // Delete matrix for the index of each node.
-    // Delete matrix for the lowlink of each node.
-    delete [] nodeIndex;
-    delete [] nodeLowlink;
+    long long numPaths = 0;
+    vector <const int *> nextNeighbor(1,g.outBegin(a));
+    vector <uint64_t> onPath(bitWords(numNodes),0);
+    setBit(onPath.data(),a);
+    while (path.size() != 0)
+    {
+        int depth = path.size() - 1;
+        int v = path[depth];
+        if (nextNeighbor[depth] == g.outEnd(v))
+        {
+            clearBit(onPath.data(),v);
+            path.pop_back();
+            nextNeighbor.pop_back();
+            continue;
+        }
+        int w = *(nextNeighbor[depth]);
+        nextNeighbor[depth]++;
+        // With w the path has depth+2 nodes, and needs distToEnd[w] more.
+        if (distToEnd[w] == -1 || testBit(onPath.data(),w) == 1 ||
+            (maxLength != -1 && depth + 2 + distToEnd[w] > maxLength) ||
+            (directed == 0 && g.hasEdge(w,v) == 0))
+        {
+            continue;
+        }
+        path.push_back(w);
+        if (w == b)
+        {
+            numPaths++;
+            int goOn = visit(path.data(),path.size());
+            path.pop_back();
+            if (goOn == 0)
+            {
+                break;
+            }
+            continue;
+        }
+        nextNeighbor.push_back(g.outBegin(w));
+        setBit(onPath.data(),w);
+    }
+    return numPaths;
+}
+
+long long visitAllPaths(int **adjMat, int numNodes, int a, int b, int directed, int maxLength, const function <int (const int *, int)> &visit)
+{
+    csrGraph g(adjMat,numNodes);
+    return visitAllPaths(g,a,b,directed,maxLength,visit);
+}
 
-    return strongConComps;
 
+
+// This returns a list of list of strongly connected components.
+// The matrix is read once into a csrGraph and tarjanComponents does the work.
+list <set <int> > tarjan (int **adjMatrix, int numNodes)
+{
+    csrGraph g(adjMatrix, numNodes);
+    return tarjan(g);
 }
 
+// This is the original recursive version. tarjan no longer uses it.
 void strongConnect(int **adjMatrix, int *nodeIndex, int *nodeLowlink, int numNodes, int curNode, int &index, list <int> &myQueue, set <int> &myQueueContents, list < set <int> > &strongConComps)
 {
     //cout << "[strongConnect] index:" << index << " curNode: " << curNode << endl;
@@ -250,809 +387,5455 @@ void strongConnect(int **adjMatrix, int *nodeIndex, int *nodeLowlink, int numNod
 
 }
 
-
-// This takes in a direct graph in adjMat. It fills in spanTreeAndBackEdges with a
-// spanning tree (given by 1's) and back edges (-1's). Each back edge defines
-// a cycle. Assumes spanTreeAndBackEdges is already allocated.
-// Assumes the graph is connected.
-void spanTreeWithBackEdges (int **adjMat, int **spanTreeAndBackEdges, int numNodes)
+// Same as above on a csrGraph, using tarjanComponents.
+list <set <int> > tarjan (const csrGraph &g)
 {
-    int *visited = new int[numNodes];
+    int numNodes = g.getNumNodes();
+    int *compId = new int[numNodes];
+    int numComps = tarjanComponents(g, compId);
+
+    vector <set <int> > comps(numComps);
     for (int i=0;i<numNodes;i++)
     {
-        visited[i] = 0; // 0 means not visiteded. 1 means visited.
+        comps[compId[i]].insert(i);
     }
+    delete [] compId;
 
-    // Zero out the data structure 
+    return list <set <int> > (comps.begin(),comps.end());
+}
+
+// The recursion of strongConnect is replaced by callStack, which holds the nodes
+// whose neighbors are still being scanned. nextNeighbor[v] remembers where the
+// scan of v is. Membership in the component stack is one bit per node.
+int tarjanComponents(const csrGraph &g, int *compId)
+{
+    int numNodes = g.getNumNodes();
+    int *nodeIndex   = new int[numNodes];
+    int *nodeLowlink = new int[numNodes];
+    int *callStack   = new int[numNodes];
+    int *compStack   = new int[numNodes];
+    const int **nextNeighbor = new const int *[numNodes];
+    uint64_t *onStack = new uint64_t[bitWords(numNodes)];
     for (int i=0;i<numNodes;i++)
     {
-        for (int j=0;j<numNodes;j++)
-        {
-            spanTreeAndBackEdges[i][j] = 0;
-        }
+        nodeIndex[i] = -1; //-1 means undef
     }
+    memset(onStack,0,bitWords(numNodes)*sizeof(uint64_t));
 
-    // Find a node that has an edge.
-    int startNode;
-    for (int i=0;i<numNodes;i++)
+    int index = 0;
+    int numComps = 0;
+    int callTop = 0;
+    int compTop = 0;
+    for (int startNode=0;startNode<numNodes;startNode++)
     {
-        for (int j=0;j<numNodes;j++)
+        if (nodeIndex[startNode] != -1)
         {
-            if (adjMat[i][j] == 1)
-            {
-                startNode = i;
-                i=numNodes; // Quit for loops
-                j=numNodes;
-            }
+            continue;
         }
-    }
-    STWBE_DFS(adjMat,spanTreeAndBackEdges,visited,numNodes, startNode);
-    delete [] visited;  
-}
 
-// Actual recursive DFS function to compute the spanning tree and back edges
-void STWBE_DFS (int **adjMat, int **spanTreeAndBackEdges,  int *visited, int numNodes, int curNode)
-{
-    visited[curNode] = 1; // Mark as visited
+        nodeIndex[startNode] = nodeLowlink[startNode] = index++;
+        compStack[compTop++] = startNode;
+        setBit(onStack,startNode);
+        nextNeighbor[startNode] = g.outBegin(startNode);
+        callStack[callTop++] = startNode;
 
-    for (int i=0;i<numNodes;i++)
-    {
-        if (adjMat[curNode][i] == 1 && i != curNode)
+        while (callTop != 0)
         {
-            if (visited[i] == 0) // Not visited
+            int curNode = callStack[callTop-1];
+            if (nextNeighbor[curNode] != g.outEnd(curNode))
             {
-                // Mark curNode -> i as an edge in the spanning tree
-                spanTreeAndBackEdges[curNode][i] = 1;
-                // Recurse on i
-                //cout << "    recursing..." << endl;
-                STWBE_DFS(adjMat,spanTreeAndBackEdges,visited,numNodes,i);
+                int i = *(nextNeighbor[curNode]);
+                nextNeighbor[curNode]++;
+                if (i == curNode)
+                {
+                    continue;
+                }
+                if (nodeIndex[i] == -1) // undef
+                {
+                    // "Recurse" on i
+                    nodeIndex[i] = nodeLowlink[i] = index++;
+                    compStack[compTop++] = i;
+                    setBit(onStack,i);
+                    nextNeighbor[i] = g.outBegin(i);
+                    callStack[callTop++] = i;
+                }
+                else if (testBit(onStack,i) == 1)
+                {
+                    nodeLowlink[curNode] = min(nodeLowlink[curNode],nodeIndex[i]);
+                }
+                continue;
             }
-            else 
+
+            // All neighbors of curNode are done.
+            callTop--;
+            if (nodeLowlink[curNode] == nodeIndex[curNode])
             {
-                // It is already visited. Mark it as a back edge.
-                spanTreeAndBackEdges[curNode][i] = -1;
+                // Pop the strongly connected component.
+                int tempInt;
+                do
+                {
+                    tempInt = compStack[--compTop];
+                    clearBit(onStack,tempInt);
+                    compId[tempInt] = numComps;
+                } while (tempInt != curNode);
+                numComps++;
+            }
+            if (callTop != 0)
+            {
+                int parentNode = callStack[callTop-1];
+                nodeLowlink[parentNode] = min(nodeLowlink[parentNode],nodeLowlink[curNode]);
             }
         }
     }
 
+    delete [] nodeIndex;
+    delete [] nodeLowlink;
+    delete [] callStack;
+    delete [] compStack;
+    delete [] nextNeighbor;
+    delete [] onStack;
+
+    return numComps;
 }
 
-// Assumes both adjMat and subAdjMat are allocated.
-// This fill subAdjMat with the values of adjMat indexed by mySet
-void getSubAdjMat (int **adjMat, int **subAdjMat, int numNodes, set <int> mySet)
+
+graphThreadPool::graphThreadPool(int someNumThreads)
 {
-    for (int i=0;i<numNodes;i++)
+    unfinishedTasks = 0;
+    stopping = 0;
+    for (int i=0;i<someNumThreads;i++)
     {
-        for (int j=0;j<numNodes;j++)
-        {
-            if (mySet.find(i)!=mySet.end() && mySet.find(j) != mySet.end())
-            {
-                subAdjMat[i][j] = adjMat[i][j];
-            }
-            else 
-            {
-                subAdjMat[i][j] = 0;
-            }
-        }
+        workers.push_back(thread(&graphThreadPool::workerLoop,this));
     }
 }
 
-// Allocated adjacency matrix
-int **allocateAdjMat(int numNodes)
+graphThreadPool::~graphThreadPool()
 {
-    int **adjMat = new int *[numNodes];
+    wait();
+    {
+        unique_lock <mutex> guard(queueLock);
+        stopping = 1;
+    }
+    taskAdded.notify_all();
+    for (int i=0;i<workers.size();i++)
+    {
+        workers[i].join();
+    }
+}
 
-    for (int i=0;i<numNodes;i++)
+void graphThreadPool::addTask(const function <void ()> &task)
+{
     {
-        adjMat[i] = new int[numNodes];
-        for (int j=0;j<numNodes;j++)
-        {
-            adjMat[i][j] = 0; //Lets be nice and set to 0
-        }
+        unique_lock <mutex> guard(queueLock);
+        tasks.push_back(task);
+        unfinishedTasks++;
     }
-    return adjMat;
+    taskAdded.notify_one();
 }
 
-// Deletes adjacency matrix
-void deleteAdjMat(int **adjMat,int numNodes)
+void graphThreadPool::wait()
 {
-    for (int i=0;i<numNodes;i++)
+    unique_lock <mutex> guard(queueLock);
+    while (unfinishedTasks != 0)
     {
-        delete [] adjMat[i];
+        tasksDone.wait(guard);
     }
-    delete [] adjMat;
 }
 
-// This will set -1 in adjMat to 0
-void stripNeg(int **adjMat, int **newAdjMat, int numNodes)
+void graphThreadPool::workerLoop()
 {
-    for (int i=0;i<numNodes;i++)
+    while (1)
     {
-        for (int j=0;j<numNodes;j++)
+        function <void ()> task;
         {
-            if (adjMat[i][j] == -1)
+            unique_lock <mutex> guard(queueLock);
+            while (tasks.size() == 0 && stopping == 0)
             {
-                newAdjMat[i][j] = 0;
+                taskAdded.wait(guard);
             }
-            else 
+            if (tasks.size() == 0)
             {
-                newAdjMat[i][j] = adjMat[i][j];
+                return; // stopping
             }
+            task = tasks.front();
+            tasks.pop_front();
+        }
+
+        task();
+
+        unique_lock <mutex> guard(queueLock);
+        unfinishedTasks--;
+        if (unfinishedTasks == 0)
+        {
+            tasksDone.notify_all();
         }
     }
 }
 
-void printMat (int **adjMat, int numNodes)
+// Shared state of one parallelComponents run. color[v] says which part of the
+// forward-backward recursion v is in; -1 means its component is known. Tasks only
+// ever write nodes of their own color, so they never write the same entry. They do
+// look at the color of neighbors in other parts, so color is read and written with
+// relaxed atomics wherever another task may be at it.
+struct parallelSCCState
 {
-    for (int i=0;i<numNodes;i++)
+    const csrGraph *g;
+    int *compId;
+    int *color;
+    int *nodeIndex;
+    int *nodeLowlink;
+    atomic <int> nextColor;
+    atomic <int> nextComp;
+    graphThreadPool *pool;
+};
+
+// Parts of the forward-backward recursion smaller than this are finished with Tarjan.
+const int PARALLEL_SCC_MIN_TASK = 4096;
+
+// Breadth first search from startNode along out edges (forward = 1) or in edges
+// (forward = 0). Nodes of color fromColor are recolored toColor, nodes of color
+// fromColorTwo (if not -2) are recolored toColorTwo, other nodes are not entered.
+// If pool is not NULL each level of the search is split among its threads, with
+// a compare and swap on color deciding which thread gets a node.
+void sccBFS(parallelSCCState &state, int startNode, int forward, int fromColor, int toColor, int fromColorTwo, int toColorTwo, graphThreadPool *pool)
+{
+    const csrGraph &g = *(state.g);
+    int *color = state.color;
+    vector <int> frontier;
+    frontier.push_back(startNode);
+    __atomic_store_n(&color[startNode], color[startNode] == fromColor ? toColor : toColorTwo, __ATOMIC_RELAXED);
+
+    while (frontier.size() != 0)
     {
-        for (int j=0;j<numNodes;j++)
+        int numChunks = 1;
+        if (pool != NULL && frontier.size() >= 1024)
         {
-            cout << setw(2) << adjMat[i][j] << " ";
+            numChunks = pool->getNumThreads();
+        }
+        vector <vector <int> > nextFrontier(numChunks);
+        for (int chunk=0;chunk<numChunks;chunk++)
+        {
+            function <void ()> expand = [&, chunk]()
+            {
+                size_t first = frontier.size()*chunk/numChunks;
+                size_t last = frontier.size()*(chunk+1)/numChunks;
+                for (size_t k=first;k<last;k++)
+                {
+                    int curNode = frontier[k];
+                    const int *nit = forward == 1 ? g.outBegin(curNode) : g.inBegin(curNode);
+                    const int *nend = forward == 1 ? g.outEnd(curNode) : g.inEnd(curNode);
+                    for (;nit!=nend;nit++)
+                    {
+                        int i = *nit;
+                        int iColor = __atomic_load_n(&color[i], __ATOMIC_RELAXED);
+                        if ((iColor == fromColor && __sync_bool_compare_and_swap(&color[i],fromColor,toColor)) ||
+                            (fromColorTwo != -2 && iColor == fromColorTwo && __sync_bool_compare_and_swap(&color[i],fromColorTwo,toColorTwo)))
+                        {
+                            nextFrontier[chunk].push_back(i);
+                        }
+                    }
+                }
+            };
+            if (numChunks == 1)
+            {
+                expand();
+            }
+            else
+            {
+                pool->addTask(expand);
+            }
+        }
+        if (numChunks != 1)
+        {
+            pool->wait();
+        }
+        frontier.clear();
+        for (int chunk=0;chunk<numChunks;chunk++)
+        {
+            frontier.insert(frontier.end(),nextFrontier[chunk].begin(),nextFrontier[chunk].end());
         }
-        cout << endl;
     }
 }
 
-void printListInt (list <int> &myList)
+// Tarjan's algorithm on the nodes of one color. A visited node is on the component
+// stack exactly when its component is not assigned yet, so no extra array is needed.
+void sccTarjanPart(parallelSCCState &state, const vector <int> &nodes, int myColor)
 {
-    list <int>::iterator lit;
-    for (lit=myList.begin();lit!=myList.end();lit++)
+    const csrGraph &g = *(state.g);
+    int *color = state.color;
+    int *compId = state.compId;
+    int *nodeIndex = state.nodeIndex;
+    int *nodeLowlink = state.nodeLowlink;
+    vector <int> callStack;
+    vector <int> compStack;
+    vector <const int *> nextNeighbor(nodes.size());
+    int index = 0;
+
+    // The indices start at 0 for each part, so nextNeighbor can be indexed by them.
+    for (int k=0;k<nodes.size();k++)
     {
-        cout << *lit << " " ;
+        nodeIndex[nodes[k]] = -1;
     }
-    cout << endl;
-}
+    for (int k=0;k<nodes.size();k++)
+    {
+        int startNode = nodes[k];
+        if (nodeIndex[startNode] != -1)
+        {
+            continue;
+        }
+        nodeIndex[startNode] = nodeLowlink[startNode] = index;
+        nextNeighbor[index] = g.outBegin(startNode);
+        index++;
+        compStack.push_back(startNode);
+        callStack.push_back(startNode);
 
-void printSetInt (set <int> &mySet)
-{
-    set <int>::iterator sit;
-    for (sit=mySet.begin();sit!=mySet.end();sit++)
+        while (callStack.size() != 0)
+        {
+            int curNode = callStack.back();
+            const int *&nit = nextNeighbor[nodeIndex[curNode]];
+            if (nit != g.outEnd(curNode))
+            {
+                int i = *nit;
+                nit++;
+                if (i == curNode || __atomic_load_n(&color[i], __ATOMIC_RELAXED) != myColor)
+                {
+                    continue;
+                }
+                if (nodeIndex[i] == -1)
+                {
+                    nodeIndex[i] = nodeLowlink[i] = index;
+                    nextNeighbor[index] = g.outBegin(i);
+                    index++;
+                    compStack.push_back(i);
+                    callStack.push_back(i);
+                }
+                else if (compId[i] == -1)
+                {
+                    nodeLowlink[curNode] = min(nodeLowlink[curNode],nodeIndex[i]);
+                }
+                continue;
+            }
+
+            callStack.pop_back();
+            if (nodeLowlink[curNode] == nodeIndex[curNode])
+            {
+                int newComp = state.nextComp++;
+                int tempInt;
+                do
+                {
+                    tempInt = compStack.back();
+                    compStack.pop_back();
+                    compId[tempInt] = newComp;
+                } while (tempInt != curNode);
+            }
+            if (callStack.size() != 0)
+            {
+                int parentNode = callStack.back();
+                nodeLowlink[parentNode] = min(nodeLowlink[parentNode],nodeLowlink[curNode]);
+            }
+        }
+    }
+
+    for (int k=0;k<nodes.size();k++)
     {
-        cout << *sit << " " ;
+        __atomic_store_n(&color[nodes[k]], -1, __ATOMIC_RELAXED);
     }
-    cout << endl;
 }
 
-// This assumes adjMat is a spanning tree. This returns the ordered path
-// from startNode to endNode if it exists.
-list <int> pathInSpanningTree(int **adjMat, int numNodes, int startNode, int endNode)
+// One step of the forward-backward recursion on the nodes of color myColor.
+// The component of a pivot is its forward set intersected with its backward set;
+// the three remaining parts can not share a component and become new tasks.
+// pool is only given for the first, whole graph, step which runs on the calling
+// thread; there each search is spread over the threads.
+void sccForwardBackward(parallelSCCState &state, vector <int> nodes, int myColor, graphThreadPool *pool)
 {
-    list <int> path;
-    if (pathInSpanningTreeDFS(adjMat,numNodes,startNode,endNode,path) == 1)
+    if (nodes.size() < PARALLEL_SCC_MIN_TASK)
     {
-        path.push_front(startNode);
+        sccTarjanPart(state, nodes, myColor);
+        return;
+    }
+
+    const csrGraph &g = *(state.g);
+    int *color = state.color;
+
+    // Pivot with the most in times out edges, it is likely in a large component.
+    int pivot = nodes[0];
+    long bestScore = -1;
+    for (int k=0;k<nodes.size();k++)
+    {
+        long score = (long)(g.outDegree(nodes[k])+1)*(g.inDegree(nodes[k])+1);
+        if (score > bestScore)
+        {
+            bestScore = score;
+            pivot = nodes[k];
+        }
+    }
+
+    int forwardColor = state.nextColor++;
+    int backwardColor = state.nextColor++;
+    int bothColor = state.nextColor++;
+    sccBFS(state, pivot, 1, myColor, forwardColor, -2, -2, pool);
+    sccBFS(state, pivot, 0, myColor, backwardColor, forwardColor, bothColor, pool);
+
+    int newComp = state.nextComp++;
+    vector <int> forwardNodes, backwardNodes, restNodes;
+    for (int k=0;k<nodes.size();k++)
+    {
+        int i = nodes[k];
+        if (color[i] == bothColor)
+        {
+            state.compId[i] = newComp;
+            __atomic_store_n(&color[i], -1, __ATOMIC_RELAXED);
+        }
+        else if (color[i] == forwardColor)
+        {
+            forwardNodes.push_back(i);
+        }
+        else if (color[i] == backwardColor)
+        {
+            backwardNodes.push_back(i);
+        }
+        else
+        {
+            restNodes.push_back(i);
+        }
+    }
+    nodes.clear();
+
+    if (forwardNodes.size() != 0)
+    {
+        state.pool->addTask(bind(sccForwardBackward, ref(state), forwardNodes, forwardColor, (graphThreadPool *)NULL));
+    }
+    if (backwardNodes.size() != 0)
+    {
+        state.pool->addTask(bind(sccForwardBackward, ref(state), backwardNodes, backwardColor, (graphThreadPool *)NULL));
+    }
+    if (restNodes.size() != 0)
+    {
+        state.pool->addTask(bind(sccForwardBackward, ref(state), restNodes, myColor, (graphThreadPool *)NULL));
+    }
+}
+
+int parallelComponents(const csrGraph &g, int *compId, int numThreads, int minParallelNodes)
+{
+    int numNodes = g.getNumNodes();
+    if (numThreads <= 1 || numNodes < minParallelNodes)
+    {
+        tarjanComponents(g, compId);
+    }
+    else if (g.hasReverse() == 0)
+    {
+        csrGraph withReverse = g;
+        withReverse.buildReverse();
+        return parallelComponents(withReverse, compId, numThreads, minParallelNodes);
+    }
+    else
+    {
+        graphThreadPool pool(numThreads);
+        parallelSCCState state;
+        state.g = &g;
+        state.compId = compId;
+        state.color = new int[numNodes];
+        state.nodeIndex = new int[numNodes];
+        state.nodeLowlink = new int[numNodes];
+        state.nextColor = 1;
+        state.nextComp = 0;
+        state.pool = &pool;
+
+        // Trim. Count in and out degrees (without self loops) in parallel, then
+        // peel off nodes that have none, one component each.
+        int *inDeg = state.nodeIndex;
+        int *outDeg = state.nodeLowlink;
+        int numChunks = pool.getNumThreads();
+        for (int chunk=0;chunk<numChunks;chunk++)
+        {
+            pool.addTask([&, chunk]()
+            {
+                int first = (long)numNodes*chunk/numChunks;
+                int last = (long)numNodes*(chunk+1)/numChunks;
+                for (int i=first;i<last;i++)
+                {
+                    state.color[i] = 0;
+                    compId[i] = -1;
+                    int selfLoop = g.hasEdge(i,i);
+                    outDeg[i] = g.outDegree(i) - selfLoop;
+                    inDeg[i] = g.inDegree(i) - selfLoop;
+                }
+            });
+        }
+        pool.wait();
+
+        vector <int> trimQueue;
+        for (int i=0;i<numNodes;i++)
+        {
+            if (inDeg[i] == 0 || outDeg[i] == 0)
+            {
+                trimQueue.push_back(i);
+            }
+        }
+        while (trimQueue.size() != 0)
+        {
+            int curNode = trimQueue.back();
+            trimQueue.pop_back();
+            if (state.color[curNode] == -1)
+            {
+                continue;
+            }
+            state.color[curNode] = -1;
+            compId[curNode] = state.nextComp++;
+            for (const int *nit=g.outBegin(curNode);nit!=g.outEnd(curNode);nit++)
+            {
+                if (*nit != curNode && state.color[*nit] == 0 && --inDeg[*nit] == 0)
+                {
+                    trimQueue.push_back(*nit);
+                }
+            }
+            for (const int *nit=g.inBegin(curNode);nit!=g.inEnd(curNode);nit++)
+            {
+                if (*nit != curNode && state.color[*nit] == 0 && --outDeg[*nit] == 0)
+                {
+                    trimQueue.push_back(*nit);
+                }
+            }
+        }
+
+        vector <int> remaining;
+        for (int i=0;i<numNodes;i++)
+        {
+            if (state.color[i] == 0)
+            {
+                remaining.push_back(i);
+            }
+        }
+        if (remaining.size() != 0)
+        {
+            sccForwardBackward(state, remaining, 0, &pool);
+        }
+        pool.wait();
+
+        delete [] state.color;
+        delete [] state.nodeIndex;
+        delete [] state.nodeLowlink;
+    }
+
+    // Number the components by their smallest node.
+    int *newId = new int[numNodes];
+    for (int i=0;i<numNodes;i++)
+    {
+        newId[i] = -1;
+    }
+    int numComps = 0;
+    for (int i=0;i<numNodes;i++)
+    {
+        if (newId[compId[i]] == -1)
+        {
+            newId[compId[i]] = numComps++;
+        }
+        compId[i] = newId[compId[i]];
+    }
+    delete [] newId;
+
+    return numComps;
+}
+
+int isAcyclic(const csrGraph &g, int *topoOrder, int *cycle, int *cycleLength)
+{
+    int numNodes = g.getNumNodes();
+    int *nodeState = new int[numNodes]; // -1 white, -2 black, else the place on the call stack
+    int *callStack = new int[numNodes];
+    const int **nextNeighbor = new const int *[numNodes];
+    for (int i=0;i<numNodes;i++)
+    {
+        nodeState[i] = -1;
+    }
+
+    int numDone = 0;
+    int callTop = 0;
+    int cycleStart = -1;
+    for (int startNode=0;startNode<numNodes && cycleStart==-1;startNode++)
+    {
+        if (nodeState[startNode] != -1)
+        {
+            continue;
+        }
+        nodeState[startNode] = callTop;
+        nextNeighbor[startNode] = g.outBegin(startNode);
+        callStack[callTop++] = startNode;
+
+        while (callTop != 0)
+        {
+            int curNode = callStack[callTop-1];
+            if (nextNeighbor[curNode] != g.outEnd(curNode))
+            {
+                int i = *(nextNeighbor[curNode]);
+                nextNeighbor[curNode]++;
+                if (nodeState[i] == -1)
+                {
+                    nodeState[i] = callTop;
+                    nextNeighbor[i] = g.outBegin(i);
+                    callStack[callTop++] = i;
+                }
+                else if (nodeState[i] >= 0)
+                {
+                    // i is on the call stack, so i .. curNode -> i is a cycle.
+                    cycleStart = nodeState[i];
+                    break;
+                }
+                continue;
+            }
+
+            // Finished nodes come out in reverse topological order.
+            callTop--;
+            nodeState[curNode] = -2;
+            if (topoOrder != NULL)
+            {
+                topoOrder[numNodes-1-numDone] = curNode;
+            }
+            numDone++;
+        }
+    }
+
+    if (cycleStart != -1 && cycle != NULL)
+    {
+        // Number the cycle c_0 .. c_k-1 in nodeState, -1 for the other nodes.
+        const int *dfsCycle = callStack + cycleStart;
+        int dfsLength = callTop - cycleStart;
+        int *walkIndex = new int[numNodes]; // Place on the walk below, only kept for the cycle
+        for (int i=0;i<numNodes;i++)
+        {
+            nodeState[i] = -1;
+        }
+        for (int j=0;j<dfsLength;j++)
+        {
+            nodeState[dfsCycle[j]] = j;
+            walkIndex[dfsCycle[j]] = -1;
+        }
+
+        // Walk from c_0 always jumping to the furthest c_j ahead. The first node of the
+        // walk with an edge back onto the walk closes the cycle, using the latest such node.
+        // The jumps leave no chords forward and stopping at the first edge back leaves none
+        // backward, so the cycle has no chords. Every edge out of the cycle is seen once.
+        int length = 0;
+        int curNode = dfsCycle[0];
+        while (1)
+        {
+            walkIndex[curNode] = length;
+            cycle[length++] = curNode;
+            int backIndex = -1;
+            int nextPlace = -1;
+            for (const int *it=g.outBegin(curNode);it!=g.outEnd(curNode);it++)
+            {
+                int place = nodeState[*it];
+                if (place == -1)
+                {
+                    continue;
+                }
+                if (walkIndex[*it] != -1)
+                {
+                    backIndex = max(backIndex,walkIndex[*it]);
+                }
+                else if (place > nodeState[curNode] && place > nextPlace)
+                {
+                    nextPlace = place;
+                }
+            }
+            if (backIndex != -1)
+            {
+                length -= backIndex;
+                memmove(cycle,cycle+backIndex,length*sizeof(int));
+                break;
+            }
+            curNode = dfsCycle[nextPlace];
+        }
+        delete [] walkIndex;
+        rotate(cycle,min_element(cycle,cycle+length),cycle+length);
+        if (cycleLength != NULL)
+        {
+            *cycleLength = length;
+        }
+    }
+
+    delete [] nodeState;
+    delete [] callStack;
+    delete [] nextNeighbor;
+
+    return cycleStart == -1 ? 1 : 0;
+}
+
+int isAcyclic(int **adjMat, int numNodes, int *topoOrder, int *cycle, int *cycleLength)
+{
+    csrGraph g(adjMat,numNodes);
+    return isAcyclic(g,topoOrder,cycle,cycleLength);
+}
+
+list <int> findCycle(const csrGraph &g)
+{
+    vector <int> cycle(g.getNumNodes());
+    int cycleLength = 0;
+    if (isAcyclic(g,NULL,cycle.data(),&cycleLength) == 1)
+    {
+        return list <int> ();
+    }
+    return list <int> (cycle.begin(),cycle.begin()+cycleLength);
+}
+
+list <int> findCycle(int **adjMat, int numNodes)
+{
+    csrGraph g(adjMat,numNodes);
+    return findCycle(g);
+}
+
+// State of one separateCycles run, shared by its calls to lightestPathBack.
+struct separateCyclesState
+{
+    const csrGraph *g;
+    vector <double> weight; // 1 - x of every edge, 0 if x is above 1.
+    vector <double> dist; // -1 is not reached yet.
+    vector <int> parent;
+    vector <char> blocked; // Nodes the paths may not go through.
+    vector <int> touched;
+};
+
+// Dijkstra search for the lightest path from u back to s through the nodes above s
+// that are not blocked, whose first edge does not go to a node in skipFirst. Fills
+// spur with the nodes of the path after u, without s, and returns its weight.
+// Returns -1 if there is no such path weighing at most bound.
+double lightestPathBack(separateCyclesState &state, int s, int u, const vector <int> &skipFirst, double bound, vector <int> &spur)
+{
+    const csrGraph &g = *state.g;
+    priority_queue <pair <double,int>, vector <pair <double,int> >, greater <pair <double,int> > > heap;
+    double closeWeight = -1.0;
+    int closeNode = -1;
+
+    state.dist[u] = 0.0;
+    state.touched.push_back(u);
+    heap.push(pair <double,int> (0.0,u));
+    while (!heap.empty())
+    {
+        double curDist = heap.top().first;
+        int curNode = heap.top().second;
+        heap.pop();
+        if (curDist > state.dist[curNode])
+        {
+            continue;
+        }
+        if (closeWeight >= 0.0 && curDist >= closeWeight)
+        {
+            break;
+        }
+        for (const int *nit=g.outBegin(curNode);nit!=g.outEnd(curNode);nit++)
+        {
+            int next = *nit;
+            if (next == curNode || (curNode == u && find(skipFirst.begin(),skipFirst.end(),next) != skipFirst.end()))
+            {
+                continue;
+            }
+            double newDist = curDist + state.weight[g.outOffset(curNode) + (nit - g.outBegin(curNode))];
+            if (newDist > bound)
+            {
+                continue;
+            }
+            if (next == s)
+            {
+                if (closeWeight < 0.0 || newDist < closeWeight)
+                {
+                    closeWeight = newDist;
+                    closeNode = curNode;
+                }
+            }
+            else if (next > s && next != u && state.blocked[next] == 0 &&
+                     (state.dist[next] < 0.0 || newDist < state.dist[next]))
+            {
+                if (state.dist[next] < 0.0)
+                {
+                    state.touched.push_back(next);
+                }
+                state.dist[next] = newDist;
+                state.parent[next] = curNode;
+                heap.push(pair <double,int> (newDist,next));
+            }
+        }
+    }
+
+    spur.clear();
+    for (int v=closeNode;v!=u && v!=-1;v=state.parent[v])
+    {
+        spur.push_back(v);
+    }
+    reverse(spur.begin(),spur.end());
+    for (int i=0;i<state.touched.size();i++)
+    {
+        state.dist[state.touched[i]] = -1.0;
+        state.parent[state.touched[i]] = -1;
+    }
+    state.touched.clear();
+    return closeWeight;
+}
+
+// The weight of cycle, added up along it from its first node, so a cycle always
+// gets the same weight however it was found.
+double separatedCycleWeight(const separateCyclesState &state, const vector <int> &cycle)
+{
+    const csrGraph &g = *state.g;
+    double weight = 0.0;
+    for (int i=0;i<cycle.size();i++)
+    {
+        int a = cycle[i];
+        int b = cycle[(i+1) % cycle.size()];
+        weight += state.weight[g.outOffset(a) + (lower_bound(g.outBegin(a),g.outEnd(a),b) - g.outBegin(a))];
+    }
+    return weight;
+}
+
+// This is Yen's k shortest paths algorithm for the paths from each s back to itself
+// through the nodes above s. Every cycle is then found from its smallest node only.
+// A cycle taken from candidates is followed by, for each of its nodes u, the lightest
+// cycle with the same nodes up to u that leaves u along an edge no cycle taken so far
+// with those nodes used. Those are never lighter, so the cycles are taken in order
+// of weight. The searches allow a little slack, since they add the weights up in
+// another order than separatedCycleWeight; whether a cycle is kept only depends on
+// its own weight.
+vector <violatedCycle> separateCycles(const csrGraph &g, const double *x, int k, double minViolation)
+{
+    int numNodes = g.getNumNodes();
+    const double slack = 1e-9;
+    double maxWeight = 1.0 - minViolation;
+    violatedCycleLighter lighter;
+    auto heavier = [&](const violatedCycle &one, const violatedCycle &two) { return lighter(two,one); };
+
+    separateCyclesState state;
+    state.g = &g;
+    state.weight.resize(g.getNumEdges());
+    for (int e=0;e<g.getNumEdges();e++)
+    {
+        state.weight[e] = x[e] < 1.0 ? 1.0 - x[e] : 0.0;
+    }
+    state.dist.assign(numNodes,-1.0);
+    state.parent.assign(numNodes,-1);
+    state.blocked.assign(numNodes,0);
+
+    vector <violatedCycle> candidates; // A heap with the lightest candidate on top.
+    set <vector <int> > seen; // Every cycle that was ever a candidate.
+    vector <int> skipFirst;
+    vector <int> spur;
+
+    // The lightest cycle of each s. Once k of them are known, an s whose lightest
+    // cycle is heavier than all k can not have a cycle among the k best.
+    vector <double> firstWeights; // A heap of the k lightest, the heaviest of them on top.
+    for (int s=0;s<numNodes;s++)
+    {
+        double bound = maxWeight;
+        if (k > 0 && (int)firstWeights.size() == k)
+        {
+            bound = min(bound,firstWeights.front());
+        }
+        if (lightestPathBack(state,s,s,skipFirst,bound + slack,spur) < 0.0)
+        {
+            continue;
+        }
+        violatedCycle newCycle;
+        newCycle.cycle.push_back(s);
+        newCycle.cycle.insert(newCycle.cycle.end(),spur.begin(),spur.end());
+        newCycle.weight = separatedCycleWeight(state,newCycle.cycle);
+        newCycle.violation = 1.0 - newCycle.weight;
+        if (newCycle.weight > maxWeight)
+        {
+            continue;
+        }
+        seen.insert(newCycle.cycle);
+        candidates.push_back(newCycle);
+        push_heap(candidates.begin(),candidates.end(),heavier);
+        firstWeights.push_back(newCycle.weight);
+        push_heap(firstWeights.begin(),firstWeights.end());
+        if (k > 0 && (int)firstWeights.size() > k)
+        {
+            pop_heap(firstWeights.begin(),firstWeights.end());
+            firstWeights.pop_back();
+        }
+    }
+
+    // The cycles come out lightest first, ties by their nodes among the candidates.
+    vector <violatedCycle> best;
+    vector < vector <int> > bestOf(numNodes); // The indices in best of the cycles of each s.
+    while (candidates.size() != 0 && (k <= 0 || (int)best.size() < k))
+    {
+        pop_heap(candidates.begin(),candidates.end(),heavier);
+        best.push_back(candidates.back());
+        candidates.pop_back();
+        const vector <int> &cycle = best.back().cycle;
+        int s = cycle[0];
+        bestOf[s].push_back(best.size()-1);
+        if (k > 0 && (int)best.size() == k)
+        {
+            break;
+        }
+
+        double rootWeight = 0.0;
+        for (int i=0;i<cycle.size();i++)
+        {
+            int u = cycle[i];
+            skipFirst.clear();
+            for (int j=0;j<bestOf[s].size();j++)
+            {
+                const vector <int> &other = best[bestOf[s][j]].cycle;
+                if (other.size() > i && equal(cycle.begin(),cycle.begin()+i+1,other.begin()))
+                {
+                    skipFirst.push_back(i+1 < other.size() ? other[i+1] : s);
+                }
+            }
+            if (lightestPathBack(state,s,u,skipFirst,maxWeight - rootWeight + slack,spur) >= 0.0)
+            {
+                violatedCycle newCycle;
+                newCycle.cycle.assign(cycle.begin(),cycle.begin()+i+1);
+                newCycle.cycle.insert(newCycle.cycle.end(),spur.begin(),spur.end());
+                newCycle.weight = separatedCycleWeight(state,newCycle.cycle);
+                newCycle.violation = 1.0 - newCycle.weight;
+                if (newCycle.weight <= maxWeight && seen.insert(newCycle.cycle).second == true)
+                {
+                    candidates.push_back(newCycle);
+                    push_heap(candidates.begin(),candidates.end(),heavier);
+                }
+            }
+            if (i+1 < cycle.size())
+            {
+                rootWeight += state.weight[g.outOffset(u) + (lower_bound(g.outBegin(u),g.outEnd(u),cycle[i+1]) - g.outBegin(u))];
+            }
+            if (i > 0)
+            {
+                state.blocked[u] = 1;
+            }
+        }
+        for (int i=1;i<cycle.size();i++)
+        {
+            state.blocked[cycle[i]] = 0;
+        }
+    }
+
+    return best;
+}
+
+vector <violatedCycle> separateCycles(int **adjMat, double **x, int numNodes, int k, double minViolation)
+{
+    csrGraph g(adjMat,numNodes);
+    vector <double> edgeX(g.getNumEdges());
+    for (int i=0;i<numNodes;i++)
+    {
+        for (const int *nit=g.outBegin(i);nit!=g.outEnd(i);nit++)
+        {
+            edgeX[g.outOffset(i) + (nit - g.outBegin(i))] = x[i][*nit];
+        }
+    }
+    return separateCycles(g,edgeX.data(),k,minViolation);
+}
+
+// This takes in a direct graph in adjMat. It fills in spanTreeAndBackEdges with a
+// spanning tree (given by 1's) and back edges (-1's). Each back edge defines
+// a cycle. Assumes spanTreeAndBackEdges is already allocated.
+// Assumes the graph is connected.
+void spanTreeWithBackEdges (int **adjMat, int **spanTreeAndBackEdges, int numNodes)
+{
+    int *visited = new int[numNodes];
+    for (int i=0;i<numNodes;i++)
+    {
+        visited[i] = 0; // 0 means not visiteded. 1 means visited.
+    }
+
+    // Zero out the data structure 
+    for (int i=0;i<numNodes;i++)
+    {
+        for (int j=0;j<numNodes;j++)
+        {
+            spanTreeAndBackEdges[i][j] = 0;
+        }
+    }
+
+    // Find a node that has an edge.
+    int startNode;
+    for (int i=0;i<numNodes;i++)
+    {
+        for (int j=0;j<numNodes;j++)
+        {
+            if (adjMat[i][j] == 1)
+            {
+                startNode = i;
+                i=numNodes; // Quit for loops
+                j=numNodes;
+            }
+        }
+    }
+    STWBE_DFS(adjMat,spanTreeAndBackEdges,visited,numNodes, startNode);
+    delete [] visited;  
+}
+
+// Actual recursive DFS function to compute the spanning tree and back edges
+void STWBE_DFS (int **adjMat, int **spanTreeAndBackEdges,  int *visited, int numNodes, int curNode)
+{
+    visited[curNode] = 1; // Mark as visited
+
+    for (int i=0;i<numNodes;i++)
+    {
+        if (adjMat[curNode][i] == 1 && i != curNode)
+        {
+            if (visited[i] == 0) // Not visited
+            {
+                // Mark curNode -> i as an edge in the spanning tree
+                spanTreeAndBackEdges[curNode][i] = 1;
+                // Recurse on i
+                //cout << "    recursing..." << endl;
+                STWBE_DFS(adjMat,spanTreeAndBackEdges,visited,numNodes,i);
+            }
+            else 
+            {
+                // It is already visited. Mark it as a back edge.
+                spanTreeAndBackEdges[curNode][i] = -1;
+            }
+        }
+    }
+
+}
+
+// Assumes both adjMat and subAdjMat are allocated.
+// This fill subAdjMat with the values of adjMat indexed by mySet
+void getSubAdjMat (int **adjMat, int **subAdjMat, int numNodes, set <int> mySet)
+{
+    for (int i=0;i<numNodes;i++)
+    {
+        for (int j=0;j<numNodes;j++)
+        {
+            if (mySet.find(i)!=mySet.end() && mySet.find(j) != mySet.end())
+            {
+                subAdjMat[i][j] = adjMat[i][j];
+            }
+            else 
+            {
+                subAdjMat[i][j] = 0;
+            }
+        }
+    }
+}
+
+// Allocated adjacency matrix
+int **allocateAdjMat(int numNodes)
+{
+    int **adjMat = new int *[numNodes];
+
+    for (int i=0;i<numNodes;i++)
+    {
+        adjMat[i] = new int[numNodes];
+        for (int j=0;j<numNodes;j++)
+        {
+            adjMat[i][j] = 0; //Lets be nice and set to 0
+        }
+    }
+    return adjMat;
+}
+
+// Deletes adjacency matrix
+void deleteAdjMat(int **adjMat,int numNodes)
+{
+    for (int i=0;i<numNodes;i++)
+    {
+        delete [] adjMat[i];
+    }
+    delete [] adjMat;
+}
+
+// This will set -1 in adjMat to 0
+void stripNeg(int **adjMat, int **newAdjMat, int numNodes)
+{
+    for (int i=0;i<numNodes;i++)
+    {
+        for (int j=0;j<numNodes;j++)
+        {
+            if (adjMat[i][j] == -1)
+            {
+                newAdjMat[i][j] = 0;
+            }
+            else 
+            {
+                newAdjMat[i][j] = adjMat[i][j];
+            }
+        }
+    }
+}
+
+void printMat (int **adjMat, int numNodes)
+{
+    for (int i=0;i<numNodes;i++)
+    {
+        for (int j=0;j<numNodes;j++)
+        {
+            cout << setw(2) << adjMat[i][j] << " ";
+        }
+        cout << endl;
+    }
+}
+
+void printListInt (list <int> &myList)
+{
+    list <int>::iterator lit;
+    for (lit=myList.begin();lit!=myList.end();lit++)
+    {
+        cout << *lit << " " ;
+    }
+    cout << endl;
+}
+
+void printSetInt (set <int> &mySet)
+{
+    set <int>::iterator sit;
+    for (sit=mySet.begin();sit!=mySet.end();sit++)
+    {
+        cout << *sit << " " ;
+    }
+    cout << endl;
+}
+
+// This assumes adjMat is a spanning tree. This returns the ordered path
+// from startNode to endNode if it exists.
+list <int> pathInSpanningTree(int **adjMat, int numNodes, int startNode, int endNode)
+{
+    list <int> path;
+    if (pathInSpanningTreeDFS(adjMat,numNodes,startNode,endNode,path) == 1)
+    {
+        path.push_front(startNode);
     }
     return path;
 
 }
 
-// This does DFS on the spanning tree adjMath. 
-// returns true if one of its children found endNode
-int pathInSpanningTreeDFS(int **adjMat, int numNodes, int curNode, int endNode, list <int> &path)
+// This does DFS on the spanning tree adjMath. 
+// returns true if one of its children found endNode
+int pathInSpanningTreeDFS(int **adjMat, int numNodes, int curNode, int endNode, list <int> &path)
+{
+    //cout << "[pathInSpanningTreeDFS] curNode: " << curNode << " path: ";
+    //printListInt(path);
+    if (curNode == endNode)
+    {
+        return 1;
+    }
+
+    for (int i=0;i<numNodes;i++)
+    {
+        if (adjMat[curNode][i] == 1 && i != curNode)
+        {
+            //recurse
+            if (pathInSpanningTreeDFS(adjMat, numNodes, i, endNode,path) == 1)
+            {
+                //cout << " curNode: " << curNode << " i:" << i << "  found endNode. " << endl;
+                // Then i is in the path
+                path.push_front(i);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+
+// This reads through the adjacency matrix and looks for -1.
+// If a -1 is found the edge i -> j is recorded.
+list <vector <int> > getBackEdges(int **adjMat, int numNodes)
+{
+    list <vector <int> > retList;
+    for (int i=0;i<numNodes;i++)
+    {
+        for (int j=0;j<numNodes;j++)
+        {
+            if (adjMat[i][j] == -1)
+            {
+                vector <int> backEdge;
+                backEdge.clear();
+                backEdge.insert(backEdge.begin(),j);
+                backEdge.insert(backEdge.begin(),i);
+                retList.push_back(backEdge);
+            }
+        }
+    }
+    return retList;
+}
+
+// The original version built a copy of the adjacency matrix for every component.
+list <list <int> > getMinCycles(int **adjMat,int numNodes)
+{
+    csrGraph g(adjMat,numNodes);
+    return getMinCycles(g);
+}
+
+// Same as above, on a csrGraph. Each strongly connected component is relabelled into
+// its own small csrGraph and searched by a DFS that records the spanning tree as
+// parent pointers, so nothing of size numNodes^2 is touched and the whole thing takes
+// O(n + m + total cycle length). The components come in the order of tarjan and,
+// within one, the cycles in the (row major) order of their non tree edges, as in the
+// matrix version. As there a non tree edge whose endpoint is not an ancestor gives an
+// empty list.
+list <list <int> > getMinCycles(const csrGraph &g)
+{
+    int numNodes = g.getNumNodes();
+    list <list <int> > minCycles;
+
+    vector <int> compId(numNodes);
+    int numComps = tarjanComponents(g,compId.data());
+    vector <int> compOffsets(numComps+1,0);
+    for (int i=0;i<numNodes;i++)
+    {
+        compOffsets[compId[i]+1]++;
+    }
+    for (int comp=0;comp<numComps;comp++)
+    {
+        compOffsets[comp+1] += compOffsets[comp];
+    }
+    vector <int> compOrder(numNodes); // The nodes of each component, in increasing order.
+    vector <int> localId(numNodes);
+    vector <int> fill(compOffsets.begin(),compOffsets.end()-1);
+    for (int i=0;i<numNodes;i++)
+    {
+        localId[i] = fill[compId[i]] - compOffsets[compId[i]];
+        compOrder[fill[compId[i]]++] = i;
+    }
+
+    vector <int> nodes;
+    vector <int> offsets;
+    vector <int> neighbors;
+    for (int comp=0;comp<numComps;comp++)
+    {
+        if (compOffsets[comp+1] - compOffsets[comp] <= 1)
+        {
+            continue;
+        }
+        nodes.assign(compOrder.begin()+compOffsets[comp],compOrder.begin()+compOffsets[comp+1]);
+        offsets.assign(1,0);
+        neighbors.clear();
+        for (int i=0;i<nodes.size();i++)
+        {
+            for (const int *nit=g.outBegin(nodes[i]);nit!=g.outEnd(nodes[i]);nit++)
+            {
+                if (compId[*nit] == comp && *nit != nodes[i])
+                {
+                    neighbors.push_back(localId[*nit]);
+                }
+            }
+            offsets.push_back(neighbors.size());
+        }
+        csrGraph compGraph;
+        compGraph.fromCSR(nodes.size(),offsets,neighbors);
+        minCyclesComponent(compGraph,nodes,minCycles);
+    }
+
+    return minCycles;
+}
+
+// A node is on the stack exactly while its DFS is running, so an edge to a node on
+// the stack goes back to an ancestor.
+void minCyclesComponent(const csrGraph &compGraph, const vector <int> &nodes, list < list <int> > &minCycles)
+{
+    int size = compGraph.getNumNodes();
+    vector <int> parent(size,-1);
+    vector <char> state(size,0); // 0 not visited, 1 on the stack, 2 done.
+    vector <pair <pair <int,int>, int> > nonTreeEdges; // ((tail,head),back to an ancestor)
+    vector <int> stack(1,0);
+    vector <const int *> nextNeighbor(1,compGraph.outBegin(0));
+    state[0] = 1;
+    while (stack.size() != 0)
+    {
+        int v = stack.back();
+        const int *&nit = nextNeighbor.back();
+        if (nit == compGraph.outEnd(v))
+        {
+            state[v] = 2;
+            stack.pop_back();
+            nextNeighbor.pop_back();
+            continue;
+        }
+        int i = *nit;
+        nit++;
+        if (state[i] == 0)
+        {
+            parent[i] = v;
+            state[i] = 1;
+            stack.push_back(i);
+            nextNeighbor.push_back(compGraph.outBegin(i));
+        }
+        else
+        {
+            nonTreeEdges.push_back(pair <pair <int,int>, int> (pair <int,int> (v,i),state[i] == 1 ? 1 : 0));
+        }
+    }
+    sort(nonTreeEdges.begin(),nonTreeEdges.end());
+
+    for (int k=0;k<nonTreeEdges.size();k++)
+    {
+        list <int> path;
+        if (nonTreeEdges[k].second == 1)
+        {
+            // The tree path from the head down to the tail.
+            int head = nonTreeEdges[k].first.second;
+            for (int curNode=nonTreeEdges[k].first.first;curNode!=head;curNode=parent[curNode])
+            {
+                path.push_front(nodes[curNode]);
+            }
+            path.push_front(nodes[head]);
+        }
+        minCycles.push_back(path);
+    }
+}
+
+// A candidate of minCycleBasisComponent: the cycle through root and edge.
+struct basisCandidate
+{
+    double weight;
+    int root;
+    int edge;
+};
+
+struct basisCandidateLighter
+{
+    bool operator()(const basisCandidate &one, const basisCandidate &two) const
+    {
+        if (one.weight != two.weight)
+        {
+            return one.weight < two.weight;
+        }
+        if (one.root != two.root)
+        {
+            return one.root < two.root;
+        }
+        return one.edge < two.edge;
+    }
+};
+
+list < list <int> > getMinCycleBasis(const csrGraph &g, const double *weights)
+{
+    list < list <int> > basis;
+    int numNodes = g.getNumNodes();
+    vector <int> compId(numNodes);
+    int numComps = tarjanComponents(g,compId.data());
+    vector < vector <int> > compNodes(numComps);
+    vector <int> localId(numNodes);
+    for (int i=0;i<numNodes;i++)
+    {
+        localId[i] = compNodes[compId[i]].size();
+        compNodes[compId[i]].push_back(i);
+    }
+
+    for (int comp=0;comp<numComps;comp++)
+    {
+        vector <int> &nodes = compNodes[comp];
+        if (nodes.size() <= 1)
+        {
+            continue;
+        }
+        // The nodes are in increasing order, so the rows come out sorted.
+        vector <int> offsets(1,0);
+        vector <int> neighbors;
+        vector <double> compWeights;
+        for (int i=0;i<nodes.size();i++)
+        {
+            for (const int *nit=g.outBegin(nodes[i]);nit!=g.outEnd(nodes[i]);nit++)
+            {
+                if (compId[*nit] == comp && *nit != nodes[i])
+                {
+                    neighbors.push_back(localId[*nit]);
+                    compWeights.push_back(weights == NULL ? 1.0 : weights[g.outOffset(nodes[i]) + (nit - g.outBegin(nodes[i]))]);
+                }
+            }
+            offsets.push_back(neighbors.size());
+        }
+        csrGraph compGraph;
+        compGraph.fromCSR(nodes.size(),offsets,neighbors);
+
+        list < list <int> > compBasis;
+        minCycleBasisComponent(compGraph,compWeights.data(),compBasis);
+        list < list <int> >::iterator llit;
+        for (llit=compBasis.begin();llit!=compBasis.end();llit++)
+        {
+            list <int>::iterator lit;
+            for (lit=(*llit).begin();lit!=(*llit).end();lit++)
+            {
+                *lit = nodes[*lit];
+            }
+        }
+        basis.splice(basis.end(),compBasis);
+    }
+    return basis;
+}
+
+list < list <int> > getMinCycleBasis(int **adjMat, int numNodes)
+{
+    csrGraph g(adjMat,numNodes);
+    return getMinCycleBasis(g);
+}
+
+void minCycleBasisComponent(const csrGraph &g, const double *weights, list < list <int> > &basis)
+{
+    int numNodes = g.getNumNodes();
+    int numEdges = g.getNumEdges();
+    int dimension = numEdges - numNodes + 1;
+
+    // The tail of each edge, and the edges into each node.
+    vector <int> edgeTail(numEdges);
+    vector <int> inOffsets(numNodes+1,0);
+    vector <int> inEdges(numEdges);
+    for (int v=0;v<numNodes;v++)
+    {
+        for (int e=g.outOffset(v);e<g.outOffset(v+1);e++)
+        {
+            edgeTail[e] = v;
+            inOffsets[g.outBegin(0)[e]+1]++;
+        }
+    }
+    const int *edgeHead = g.outBegin(0);
+    for (int v=0;v<numNodes;v++)
+    {
+        inOffsets[v+1] += inOffsets[v];
+    }
+    vector <int> fill(inOffsets.begin(),inOffsets.end()-1);
+    for (int e=0;e<numEdges;e++)
+    {
+        inEdges[fill[edgeHead[e]]++] = e;
+    }
+
+    // toParent[v*numNodes + x] is the last edge of the shortest path from v to x, and
+    // fromParent[v*numNodes + x] the first edge of the shortest path from x to v, both
+    // through nodes above v only. -1 if there is none.
+    vector <int> toParent((size_t)numNodes*numNodes,-1);
+    vector <int> fromParent((size_t)numNodes*numNodes,-1);
+    vector <double> toDist(numNodes), fromDist(numNodes);
+    vector <basisCandidate> candidates;
+    priority_queue <pair <double,int>, vector <pair <double,int> >, greater <pair <double,int> > > heap;
+
+    // Dijkstra from root over the nodes above root, forward or backward.
+    auto shortestPaths = [&](int root, int forward, vector <double> &dist, int *parent)
+    {
+        fill_n(dist.begin(),numNodes,-1.0);
+        dist[root] = 0.0;
+        heap.push(pair <double,int> (0.0,root));
+        while (!heap.empty())
+        {
+            double curDist = heap.top().first;
+            int v = heap.top().second;
+            heap.pop();
+            if (curDist > dist[v])
+            {
+                continue;
+            }
+            int first = forward == 1 ? g.outOffset(v) : inOffsets[v];
+            int last = forward == 1 ? g.outOffset(v+1) : inOffsets[v+1];
+            for (int k=first;k<last;k++)
+            {
+                int e = forward == 1 ? k : inEdges[k];
+                int next = forward == 1 ? edgeHead[e] : edgeTail[e];
+                double newDist = curDist + weights[e];
+                if (next > root && (dist[next] < 0.0 || newDist < dist[next]))
+                {
+                    dist[next] = newDist;
+                    parent[next] = e;
+                    heap.push(pair <double,int> (newDist,next));
+                }
+            }
+        }
+    };
+
+    for (int v=0;v<numNodes;v++)
+    {
+        shortestPaths(v,1,toDist,toParent.data() + (size_t)v*numNodes);
+        shortestPaths(v,0,fromDist,fromParent.data() + (size_t)v*numNodes);
+        for (int e=0;e<numEdges;e++)
+        {
+            int u = edgeTail[e];
+            int w = edgeHead[e];
+            if (toDist[u] >= 0.0 && fromDist[w] >= 0.0)
+            {
+                basisCandidate newCandidate;
+                newCandidate.weight = toDist[u] + weights[e] + fromDist[w];
+                newCandidate.root = v;
+                newCandidate.edge = e;
+                candidates.push_back(newCandidate);
+            }
+        }
+    }
+    sort(candidates.begin(),candidates.end(),basisCandidateLighter());
+
+    // Row r of rows has its lowest set bit at a column no other row has it at, and
+    // pivotRow maps that column back to r. XORing a row into a vector clears the
+    // vector's lowest bit and only changes higher ones.
+    int numWords = bitWords(numEdges);
+    vector <uint64_t> rows;
+    vector <int> pivotRow(numEdges,-1);
+    vector <uint64_t> edgeBits(numWords);
+    vector <int> onCycle(numNodes,-1);
+    vector <int> cycleNodes;
+    int rank = 0;
+    for (int k=0;k<candidates.size() && rank<dimension;k++)
+    {
+        int root = candidates[k].root;
+        int e = candidates[k].edge;
+        const int *rootTo = toParent.data() + (size_t)root*numNodes;
+        const int *rootFrom = fromParent.data() + (size_t)root*numNodes;
+
+        // root -> .. -> tail, then head -> .. -> root. It must be simple.
+        fill_n(edgeBits.begin(),numWords,0);
+        cycleNodes.clear();
+        for (int x=edgeTail[e];x!=root;x=edgeTail[rootTo[x]])
+        {
+            cycleNodes.push_back(x);
+            setBit(edgeBits.data(),rootTo[x]);
+        }
+        cycleNodes.push_back(root);
+        reverse(cycleNodes.begin(),cycleNodes.end());
+        for (int i=0;i<cycleNodes.size();i++)
+        {
+            onCycle[cycleNodes[i]] = k;
+        }
+        setBit(edgeBits.data(),e);
+        int simple = 1;
+        for (int x=edgeHead[e];x!=root;x=edgeHead[rootFrom[x]])
+        {
+            if (onCycle[x] == k)
+            {
+                simple = 0;
+                break;
+            }
+            onCycle[x] = k;
+            cycleNodes.push_back(x);
+            setBit(edgeBits.data(),rootFrom[x]);
+        }
+        if (simple == 0)
+        {
+            continue;
+        }
+
+        int independent = 0;
+        for (int w=0;w<numWords && independent==0;w++)
+        {
+            while (edgeBits[w] != 0)
+            {
+                int col = (w << 6) + lowestBit(edgeBits[w]);
+                int r = pivotRow[col];
+                if (r == -1)
+                {
+                    independent = 1;
+                    pivotRow[col] = rank;
+                    break;
+                }
+                const uint64_t *row = rows.data() + (size_t)r*numWords;
+                for (int x=w;x<numWords;x++)
+                {
+                    edgeBits[x] ^= row[x];
+                }
+            }
+        }
+        if (independent == 0)
+        {
+            continue;
+        }
+        rows.insert(rows.end(),edgeBits.begin(),edgeBits.end());
+        rank++;
+        basis.push_back(list <int> (cycleNodes.begin(),cycleNodes.end()));
+    }
+}
+
+// Allocates a new matrix and fills it with a copy of the one given.
+int **copyAdjMat(int **adjMat, int numNodes)
+{
+    int **retMat = allocateAdjMat(numNodes);
+    for (int i=0;i<numNodes;i++)
+    {
+        for (int j=0;j<numNodes;j++)
+        {
+            retMat[i][j] = adjMat[i][j];
+        }
+    }
+    return retMat;
+}
+
+
+// Use the orientation rules from "Causal inference and causal explanation with background knowledge"
+// Meek 1995. Also in "Characteristic imsets for learning Bayesian network structures", Hemmecke et. al.
+// Given a CIM solution which may not be from a DAG, I think it is not correct to use the 
+// "orientation rules". That is, the orientation rules assume the graph which generated the CIM was a DAG!
+// The rules, for an undirected edge a - b, orient it a -> b if
+//   R1: some c -> a with c and b not adjacent,
+//   R2: some a -> c -> b,
+//   R3: some a - c -> b and a - d -> b with c and d not adjacent,
+//   R4: some a - c -> d -> b with c and b not adjacent and a and d adjacent.
+// Once x -> y is oriented, these can only newly hold for the undirected edges at x or y
+// and, through R4, the undirected edges from a neighbor a - x to a child of y.
+int **essGraphFromPatGraph(int **patMat, int numNodes)
+{
+    int **essMat = copyAdjMat(patMat, numNodes);
+    int numWords = bitWords(numNodes);
+    vector <uint64_t> adjacent((size_t)numNodes*numWords,0);
+    vector <uint64_t> undirected((size_t)numNodes*numWords,0);
+    vector <uint64_t> parents((size_t)numNodes*numWords,0);
+    vector <uint64_t> children((size_t)numNodes*numWords,0);
+    auto row = [&](vector <uint64_t> &bits, int v) { return bits.data() + (size_t)v*numWords; };
+
+    vector <pair <int,int> > workList;
+    for (int i=0;i<numNodes;i++)
+    {
+        for (int j=0;j<numNodes;j++)
+        {
+            if (i == j || essMat[i][j] != 1)
+            {
+                continue;
+            }
+            setBit(row(adjacent,i),j);
+            setBit(row(adjacent,j),i);
+            if (essMat[j][i] == 1)
+            {
+                setBit(row(undirected,i),j);
+                workList.push_back(pair <int,int> (i,j));
+            }
+            else
+            {
+                setBit(row(children,i),j);
+                setBit(row(parents,j),i);
+            }
+        }
+    }
+
+    // Pushes both directions of every undirected edge a - b with b in bits.
+    auto pushEdges = [&](int a, const uint64_t *bits)
+    {
+        for (int w=0;w<numWords;w++)
+        {
+            uint64_t word = bits[w] & row(undirected,a)[w];
+            while (word != 0)
+            {
+                int b = (w << 6) + lowestBit(word);
+                word &= word - 1;
+                workList.push_back(pair <int,int> (a,b));
+                workList.push_back(pair <int,int> (b,a));
+            }
+        }
+    };
+
+    while (workList.size() != 0)
+    {
+        int a = workList.back().first;
+        int b = workList.back().second;
+        workList.pop_back();
+        if (testBit(row(undirected,a),b) == 0)
+        {
+            continue;
+        }
+
+        int orient = 0;
+        // R1 and R2
+        for (int w=0;w<numWords && orient==0;w++)
+        {
+            if ((row(parents,a)[w] & ~row(adjacent,b)[w]) != 0 ||
+                (row(children,a)[w] & row(parents,b)[w]) != 0)
+            {
+                orient = 1;
+            }
+        }
+        // R3 and R4, going through the candidates for c.
+        for (int w=0;w<numWords && orient==0;w++)
+        {
+            uint64_t word = row(undirected,a)[w];
+            while (word != 0 && orient == 0)
+            {
+                int cNode = (w << 6) + lowestBit(word);
+                word &= word - 1;
+                if (cNode == b)
+                {
+                    continue;
+                }
+                const uint64_t *cAdjacent = row(adjacent,cNode);
+                if (testBit(row(parents,b),cNode) == 1)
+                {
+                    // R3: another d with a - d -> b not adjacent to c.
+                    for (int x=0;x<numWords && orient==0;x++)
+                    {
+                        uint64_t dNodes = row(undirected,a)[x] & row(parents,b)[x] & ~cAdjacent[x];
+                        if (x == (cNode >> 6))
+                        {
+                            dNodes &= ~(((uint64_t)1) << (cNode & 63));
+                        }
+                        orient = dNodes != 0 ? 1 : 0;
+                    }
+                }
+                if (orient == 0 && testBit(row(adjacent,b),cNode) == 0)
+                {
+                    // R4: some d with c -> d -> b and d adjacent to a.
+                    for (int x=0;x<numWords && orient==0;x++)
+                    {
+                        uint64_t dNodes = row(children,cNode)[x] & row(parents,b)[x] & row(adjacent,a)[x];
+                        orient = dNodes != 0 ? 1 : 0;
+                    }
+                }
+            }
+        }
+        if (orient == 0)
+        {
+            continue;
+        }
+
+        // a - b becomes a -> b.
+        essMat[b][a] = 0;
+        clearBit(row(undirected,a),b);
+        clearBit(row(undirected,b),a);
+        setBit(row(children,a),b);
+        setBit(row(parents,b),a);
+
+        pushEdges(a,row(undirected,a));
+        pushEdges(b,row(undirected,b));
+        for (int w=0;w<numWords;w++)
+        {
+            uint64_t word = row(undirected,a)[w];
+            while (word != 0)
+            {
+                int i = (w << 6) + lowestBit(word);
+                word &= word - 1;
+                pushEdges(i,row(children,b));
+            }
+        }
+    }
+
+    return essMat;
+}
+
+int **pdagToDag(int **pdagMat, int numNodes)
+{
+    int **dagMat = copyAdjMat(pdagMat, numNodes);
+    int numWords = bitWords(numNodes);
+    vector <uint64_t> adjacent((size_t)numNodes*numWords,0);
+    vector <uint64_t> undirected((size_t)numNodes*numWords,0);
+    vector <uint64_t> parents((size_t)numNodes*numWords,0);
+    vector <int> numChildren(numNodes,0);
+    auto row = [&](vector <uint64_t> &bits, int v) { return bits.data() + (size_t)v*numWords; };
+
+    for (int i=0;i<numNodes;i++)
+    {
+        dagMat[i][i] = 0;
+        for (int j=0;j<numNodes;j++)
+        {
+            if (i == j || dagMat[i][j] != 1)
+            {
+                continue;
+            }
+            setBit(row(adjacent,i),j);
+            setBit(row(adjacent,j),i);
+            if (dagMat[j][i] == 1)
+            {
+                setBit(row(undirected,i),j);
+            }
+            else
+            {
+                setBit(row(parents,j),i);
+                numChildren[i]++;
+            }
+        }
+    }
+
+    // x can be the next sink if it has no children left and each undirected
+    // neighbor y is adjacent to all the other nodes adjacent to x.
+    auto isSink = [&](int x)
+    {
+        if (numChildren[x] != 0)
+        {
+            return 0;
+        }
+        const uint64_t *xAdjacent = row(adjacent,x);
+        for (int w=0;w<numWords;w++)
+        {
+            uint64_t word = row(undirected,x)[w];
+            while (word != 0)
+            {
+                int y = (w << 6) + lowestBit(word);
+                word &= word - 1;
+                const uint64_t *yAdjacent = row(adjacent,y);
+                for (int v=0;v<numWords;v++)
+                {
+                    uint64_t missing = xAdjacent[v] & ~yAdjacent[v];
+                    if (v == w)
+                    {
+                        missing &= ~(((uint64_t)1) << (y & 63));
+                    }
+                    if (missing != 0)
+                    {
+                        return 0;
+                    }
+                }
+            }
+        }
+        return 1;
+    };
+
+    vector <int> workList(numNodes);
+    vector <int> onList(numNodes,1);
+    for (int i=0;i<numNodes;i++)
+    {
+        workList[i] = numNodes - 1 - i;
+    }
+
+    int numRemoved = 0;
+    while (workList.size() != 0)
+    {
+        int x = workList.back();
+        workList.pop_back();
+        onList[x] = 0;
+        if (isSink(x) == 0)
+        {
+            continue;
+        }
+
+        // Orient the undirected edges y - x as y -> x and take x out.
+        numRemoved++;
+        for (int w=0;w<numWords;w++)
+        {
+            uint64_t word = row(adjacent,x)[w];
+            while (word != 0)
+            {
+                int y = (w << 6) + lowestBit(word);
+                word &= word - 1;
+                if (testBit(row(undirected,x),y) == 1)
+                {
+                    dagMat[x][y] = 0;
+                    clearBit(row(undirected,y),x);
+                }
+                else if (testBit(row(parents,x),y) == 1)
+                {
+                    numChildren[y]--;
+                }
+                clearBit(row(adjacent,y),x);
+                if (onList[y] == 0)
+                {
+                    onList[y] = 1;
+                    workList.push_back(y);
+                }
+            }
+        }
+    }
+
+    if (numRemoved != numNodes)
+    {
+        deleteAdjMat(dagMat, numNodes);
+        return NULL;
+    }
+    return dagMat;
+}
+
+// Reverses the list myList
+list <int> revList(list <int> myList)
+{
+    list <int> retList;
+    if (myList.size() <= 1)
+    {
+        return myList;
+    }
+
+    list <int>::iterator lit = myList.end();
+    lit--;
+    for (;lit!=myList.begin();lit--)
+    {
+        retList.push_back(*lit);
+    }
+    retList.push_back(*lit);
+    return retList;
+}
+
+// This assumes myList is a cycle and returns the
+// representation with the minimum node number as the start.
+list <int> uniqueCycle(list <int> myList)
+{
+    list <int> retList;
+    if (myList.size() <= 1)
+    {
+        return myList;
+    }
+
+    list <int>::iterator minVal;
+    list <int>::iterator lit=myList.begin();
+    int curMin = *lit;
+    minVal = lit;
+    // Find the min value;
+    for (;lit!=myList.end();lit++)
+    {
+        if (*lit < curMin )
+        {
+            minVal = lit;
+            curMin = *lit;
+        }
+    }
+
+    lit = minVal;
+    for (int i=0;i<myList.size();i++)
+    {
+        if (lit == myList.end())
+        {
+            lit = myList.begin();
+        }
+        retList.push_back(*lit);
+        lit++;
+    }
+    return retList;
+}
+
+// Returns 1 if the graphs are the same
+int graphSame(int **adjMatOne, int **adjMatTwo, int numNodes)
+{
+    int same = 1;
+    for (int i=0;i<numNodes;i++)
+    {
+        for (int j=0;j<numNodes;j++)
+        {
+            if (adjMatOne[i][j] != adjMatTwo[i][j])
+            {
+                same = 0;
+                i = numNodes;
+                j = numNodes;
+            }
+        }
+    }
+    return same;
+}
+
+csrGraph::csrGraph()
+{
+    numNodes = 0;
+    numEdges = 0;
+    offsets.push_back(0);
+}
+
+csrGraph::csrGraph(int **adjMat, int someNumNodes, int withReverse)
+{
+    fromAdjMat(adjMat,someNumNodes,withReverse);
+}
+
+csrGraph::csrGraph(int someNumNodes, const vector <pair <int,int> > &edges, int withReverse)
+{
+    fromEdges(someNumNodes,edges,withReverse);
+}
+
+void csrGraph::fromAdjMat(int **adjMat, int someNumNodes, int withReverse)
+{
+    clear();
+    numNodes = someNumNodes;
+    offsets.resize(numNodes+1);
+    for (int i=0;i<numNodes;i++)
+    {
+        for (int j=0;j<numNodes;j++)
+        {
+            if (adjMat[i][j] == 1)
+            {
+                neighbors.push_back(j);
+            }
+        }
+        offsets[i+1] = neighbors.size();
+    }
+    numEdges = neighbors.size();
+
+    if (withReverse == 1)
+    {
+        buildReverse();
+    }
+}
+
+// Counting sort of the edges by tail, then each row is sorted and repeats removed.
+void csrGraph::fromEdges(int someNumNodes, const vector <pair <int,int> > &edges, int withReverse)
+{
+    clear();
+    numNodes = someNumNodes;
+    offsets.assign(numNodes+1,0);
+    for (int k=0;k<edges.size();k++)
+    {
+        offsets[edges[k].first+1]++;
+    }
+    for (int i=0;i<numNodes;i++)
+    {
+        offsets[i+1] += offsets[i];
+    }
+    neighbors.resize(edges.size());
+    vector <int> fill(offsets.begin(),offsets.end()-1);
+    for (int k=0;k<edges.size();k++)
+    {
+        neighbors[fill[edges[k].first]++] = edges[k].second;
+    }
+
+    int newEnd = 0;
+    for (int i=0;i<numNodes;i++)
+    {
+        int rowStart = newEnd;
+        sort(neighbors.begin()+offsets[i],neighbors.begin()+offsets[i+1]);
+        for (int k=offsets[i];k<offsets[i+1];k++)
+        {
+            if (newEnd == rowStart || neighbors[newEnd-1] != neighbors[k])
+            {
+                neighbors[newEnd++] = neighbors[k];
+            }
+        }
+        offsets[i] = rowStart;
+    }
+    offsets[numNodes] = newEnd;
+    neighbors.resize(newEnd);
+    numEdges = newEnd;
+
+    if (withReverse == 1)
+    {
+        buildReverse();
+    }
+}
+
+// Rows that are not sorted are sorted and repeats removed, as in fromEdges.
+void csrGraph::fromCSR(int someNumNodes, vector <int> &someOffsets, vector <int> &someNeighbors, int withReverse)
+{
+    clear();
+    numNodes = someNumNodes;
+    offsets.swap(someOffsets);
+    neighbors.swap(someNeighbors);
+    someOffsets.clear();
+    someNeighbors.clear();
+
+    int newEnd = 0;
+    for (int i=0;i<numNodes;i++)
+    {
+        int rowStart = newEnd;
+        int k = offsets[i];
+        while (k+1 < offsets[i+1] && neighbors[k] < neighbors[k+1])
+        {
+            k++;
+        }
+        if (k+1 < offsets[i+1])
+        {
+            sort(neighbors.begin()+offsets[i],neighbors.begin()+offsets[i+1]);
+        }
+        for (k=offsets[i];k<offsets[i+1];k++)
+        {
+            if (newEnd == rowStart || neighbors[newEnd-1] != neighbors[k])
+            {
+                neighbors[newEnd++] = neighbors[k];
+            }
+        }
+        offsets[i] = rowStart;
+    }
+    offsets[numNodes] = newEnd;
+    neighbors.resize(newEnd);
+    numEdges = newEnd;
+
+    if (withReverse == 1)
+    {
+        buildReverse();
+    }
+}
+
+// Counting sort of the edges by head. Since the tails are visited in increasing
+// order the in-neighbor lists come out sorted.
+void csrGraph::buildReverse()
+{
+    if (hasReverse() == 1)
+    {
+        return;
+    }
+    revOffsets.assign(numNodes+1,0);
+    revNeighbors.resize(numEdges);
+    for (int k=0;k<numEdges;k++)
+    {
+        revOffsets[neighbors[k]+1]++;
+    }
+    for (int i=0;i<numNodes;i++)
+    {
+        revOffsets[i+1] += revOffsets[i];
+    }
+    vector <int> fill(revOffsets.begin(),revOffsets.end()-1);
+    for (int i=0;i<numNodes;i++)
+    {
+        for (int k=offsets[i];k<offsets[i+1];k++)
+        {
+            revNeighbors[fill[neighbors[k]]++] = i;
+        }
+    }
+}
+
+void csrGraph::clear()
+{
+    numNodes = 0;
+    numEdges = 0;
+    offsets.assign(1,0);
+    neighbors.clear();
+    revOffsets.clear();
+    revNeighbors.clear();
+}
+
+int **csrGraph::toAdjMat()
+{
+    int **adjMat = allocateAdjMat(numNodes);
+    for (int i=0;i<numNodes;i++)
+    {
+        for (const int *nit=outBegin(i);nit!=outEnd(i);nit++)
+        {
+            adjMat[i][*nit] = 1;
+        }
+    }
+    return adjMat;
+}
+
+void csrGraph::print()
+{
+    for (int i=0;i<numNodes;i++)
+    {
+        const int *nit = outBegin(i);
+        for (int j=0;j<numNodes;j++)
+        {
+            int edge = 0;
+            if (nit != outEnd(i) && *nit == j)
+            {
+                edge = 1;
+                nit++;
+            }
+            cout << setw(2) << edge << " ";
+        }
+        cout << endl;
+    }
+}
+
+void skipGraphSpace(const char *&pos, const char *end)
+{
+    while (pos != end)
+    {
+        if (*pos == '#')
+        {
+            while (pos != end && *pos != '\n')
+            {
+                pos++;
+            }
+        }
+        else if (*pos == ' ' || *pos == '\n' || *pos == '\t' || *pos == '\r')
+        {
+            pos++;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+int parseGraphInt(const char *&pos, const char *end, int &value)
+{
+    skipGraphSpace(pos,end);
+    int negative = 0;
+    if (pos != end && *pos == '-')
+    {
+        negative = 1;
+        pos++;
+    }
+    if (pos == end || *pos < '0' || *pos > '9')
+    {
+        return 0;
+    }
+    int64_t number = 0;
+    while (pos != end && *pos >= '0' && *pos <= '9')
+    {
+        number = number*10 + (*pos - '0');
+        if (number > 2147483647LL)
+        {
+            return 0;
+        }
+        pos++;
+    }
+    value = negative == 1 ? -(int)number : (int)number;
+    return 1;
+}
+
+// The text is parsed straight into the csrGraph arrays. A matrix row is already
+// sorted, so only the edge list has to go through fromEdges.
+// The sizes in a header are checked against what the rest of the file can hold
+// before anything is allocated, and numNodes must leave room for numNodes + 1
+// offsets. An edge list can still claim more nodes than fit in memory, so a
+// bad_alloc while building the graph also gives 0.
+int parseGraph(const char *buf, size_t len, csrGraph &g, int format, int withReverse, int *formatRead)
+try
+{
+    const char *pos = buf;
+    const char *end = buf + len;
+
+    if (format == GRAPH_FILE_AUTO)
+    {
+        format = GRAPH_FILE_MATRIX;
+        if (len >= 8 && memcmp(buf,"GRAPHALG",8) == 0)
+        {
+            format = GRAPH_FILE_BINARY;
+        }
+        else
+        {
+            const char *first = pos;
+            skipGraphSpace(first,end);
+            if (first != end && (*first == 'E' || *first == 'e'))
+            {
+                format = GRAPH_FILE_EDGES;
+            }
+        }
+    }
+    if (formatRead != NULL)
+    {
+        *formatRead = format;
+    }
+
+    if (format == GRAPH_FILE_BINARY)
+    {
+        int header[2];
+        if (len < 8 + sizeof(header) || memcmp(buf,"GRAPHALG",8) != 0)
+        {
+            return 0;
+        }
+        memcpy(header,buf+8,sizeof(header));
+        int numNodes = header[0];
+        int numEdges = header[1];
+        if (numNodes < 0 || numNodes > INT_MAX - 1 || numEdges < 0 ||
+            len != 8 + sizeof(header) + ((size_t)numNodes + 1 + numEdges)*sizeof(int))
+        {
+            return 0;
+        }
+        vector <int> offsets(numNodes+1);
+        vector <int> neighbors(numEdges);
+        memcpy(offsets.data(),buf+8+sizeof(header),offsets.size()*sizeof(int));
+        memcpy(neighbors.data(),buf+8+sizeof(header)+offsets.size()*sizeof(int),neighbors.size()*sizeof(int));
+        if (offsets[0] != 0 || offsets[numNodes] != numEdges)
+        {
+            return 0;
+        }
+        for (int i=0;i<numNodes;i++)
+        {
+            if (offsets[i] > offsets[i+1])
+            {
+                return 0;
+            }
+        }
+        for (int k=0;k<numEdges;k++)
+        {
+            if (neighbors[k] < 0 || neighbors[k] >= numNodes)
+            {
+                return 0;
+            }
+        }
+        g.fromCSR(numNodes,offsets,neighbors,withReverse);
+        return 1;
+    }
+
+    if (format == GRAPH_FILE_EDGES)
+    {
+        int numNodes = -1;
+        int numEdges = -1;
+        // The header is optional.
+        skipGraphSpace(pos,end);
+        if (pos != end && (*pos == 'E' || *pos == 'e'))
+        {
+            pos++;
+            if (parseGraphInt(pos,end,numNodes) == 0 || parseGraphInt(pos,end,numEdges) == 0 ||
+                numNodes < 0 || numNodes > INT_MAX - 1 || numEdges < 0)
+            {
+                return 0;
+            }
+            // Every edge takes at least "0 0" and a space before the next one.
+            if ((long long)numEdges*4 > (long long)(end - pos) + 1)
+            {
+                return 0;
+            }
+        }
+
+        vector <pair <int,int> > edges;
+        if (numEdges != -1)
+        {
+            edges.reserve(numEdges);
+        }
+        int maxNode = -1;
+        int tail, head;
+        while (parseGraphInt(pos,end,tail) == 1)
+        {
+            if (parseGraphInt(pos,end,head) == 0 || tail < 0 || head < 0)
+            {
+                return 0;
+            }
+            maxNode = max(maxNode,max(tail,head));
+            edges.push_back(pair <int,int> (tail,head));
+        }
+        skipGraphSpace(pos,end);
+        if (pos != end) // Something other than a number.
+        {
+            return 0;
+        }
+        if (numNodes == -1)
+        {
+            if ((long long)maxNode + 1 > INT_MAX - 1)
+            {
+                return 0;
+            }
+            numNodes = maxNode + 1;
+        }
+        else if (maxNode >= numNodes || (int)edges.size() != numEdges)
+        {
+            return 0;
+        }
+        g.fromEdges(numNodes,edges,withReverse);
+        return 1;
+    }
+
+    int numNodes;
+    if (parseGraphInt(pos,end,numNodes) == 0 || numNodes < 0)
+    {
+        return 0;
+    }
+    // Every entry of the matrix takes at least a digit and a space.
+    if ((long long)numNodes*numNodes > ((long long)(end - pos) + 1)/2)
+    {
+        return 0;
+    }
+    vector <int> offsets(numNodes+1,0);
+    vector <int> neighbors;
+    int value;
+    for (int i=0;i<numNodes;i++)
+    {
+        for (int j=0;j<numNodes;j++)
+        {
+            if (parseGraphInt(pos,end,value) == 0)
+            {
+                return 0;
+            }
+            if (value == 1)
+            {
+                neighbors.push_back(j);
+            }
+        }
+        offsets[i+1] = neighbors.size();
+    }
+    skipGraphSpace(pos,end);
+    if (pos != end)
+    {
+        return 0;
+    }
+    g.fromCSR(numNodes,offsets,neighbors,withReverse);
+    return 1;
+}
+catch (const bad_alloc &)
+{
+    return 0;
+}
+
+int readGraph(const char *fileName, csrGraph &g, int format, int withReverse, int *formatRead)
+{
+    if (fileName == NULL || strcmp(fileName,"-") == 0)
+    {
+        // A pipe can not be mapped, so standard input is read into memory.
+        vector <char> buf;
+        size_t len = 0;
+        size_t numRead;
+        do
+        {
+            buf.resize(len + (1 << 20));
+            numRead = fread(buf.data() + len,1,buf.size() - len,stdin);
+            len += numRead;
+        } while (numRead != 0);
+        return parseGraph(buf.data(),len,g,format,withReverse,formatRead);
+    }
+
+    int fd = open(fileName,O_RDONLY);
+    if (fd == -1)
+    {
+        return 0;
+    }
+    struct stat fileStat;
+    if (fstat(fd,&fileStat) == -1)
+    {
+        close(fd);
+        return 0;
+    }
+    size_t len = fileStat.st_size;
+    if (len == 0)
+    {
+        close(fd);
+        return parseGraph(NULL,0,g,format,withReverse,formatRead);
+    }
+    void *buf = mmap(NULL,len,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if (buf == MAP_FAILED)
+    {
+        return 0;
+    }
+    madvise(buf,len,MADV_SEQUENTIAL);
+    int retVal = parseGraph((const char *)buf,len,g,format,withReverse,formatRead);
+    munmap(buf,len);
+    return retVal;
+}
+
+int writeGraph(const char *fileName, const csrGraph &g, int format)
+{
+    FILE *out = fopen(fileName,"wb");
+    if (out == NULL)
+    {
+        return 0;
+    }
+    int numNodes = g.getNumNodes();
+    int numEdges = g.getNumEdges();
+    int written = 1; // Set to 0 by the first short write.
+    if (format == GRAPH_FILE_BINARY)
+    {
+        int header[2] = {numNodes, numEdges};
+        vector <int> offsets(numNodes+1,0);
+        for (int i=0;i<numNodes;i++)
+        {
+            offsets[i+1] = offsets[i] + g.outDegree(i);
+        }
+        if (fwrite("GRAPHALG",1,8,out) != 8 || fwrite(header,sizeof(int),2,out) != 2 ||
+            fwrite(offsets.data(),sizeof(int),offsets.size(),out) != offsets.size())
+        {
+            written = 0;
+        }
+        else if (numNodes > 0 && fwrite(g.outBegin(0),sizeof(int),numEdges,out) != (size_t)numEdges)
+        {
+            written = 0;
+        }
+    }
+    else if (format == GRAPH_FILE_EDGES)
+    {
+        if (fprintf(out,"E %d %d\n",numNodes,numEdges) < 0)
+        {
+            written = 0;
+        }
+        for (int i=0;i<numNodes && written==1;i++)
+        {
+            for (const int *nit=g.outBegin(i);nit!=g.outEnd(i) && written==1;nit++)
+            {
+                if (fprintf(out,"%d %d\n",i,*nit) < 0)
+                {
+                    written = 0;
+                }
+            }
+        }
+    }
+    else
+    {
+        if (fprintf(out,"%d\n",numNodes) < 0)
+        {
+            written = 0;
+        }
+        for (int i=0;i<numNodes && written==1;i++)
+        {
+            const int *nit = g.outBegin(i);
+            for (int j=0;j<numNodes && written==1;j++)
+            {
+                int edge = 0;
+                if (nit != g.outEnd(i) && *nit == j)
+                {
+                    edge = 1;
+                    nit++;
+                }
+                if (fprintf(out,j+1 < numNodes ? "%d " : "%d\n",edge) < 0)
+                {
+                    written = 0;
+                }
+            }
+        }
+    }
+    if (fclose(out) != 0)
+    {
+        written = 0;
+    }
+    return written;
+}
+
+cycleGenerator::cycleGenerator()
+{
+    init();
+}
+
+cycleGenerator::~cycleGenerator()
+{
+    closeSpillFiles();
+    delete threadPool;
+}
+
+cycleGenerator::cycleGenerator(int **someAdjMat,int someNumNodes)
+{
+    init();
+    copyAdjMatInt(someAdjMat,someNumNodes);
+}
+
+cycleGenerator::cycleGenerator(const csrGraph &someGraph)
+{
+    init();
+    copyGraph(someGraph);
+}
+
+void cycleGenerator::copyAdjMatInt(int **someAdjMat,int someNumNodes)
+{
+    graph.fromAdjMat(someAdjMat, someNumNodes);
+    numNodes = someNumNodes;
+    buildBitRows();
+    buildCloseDistances();
+
+    addVertToPathQueue();
+}
+
+void cycleGenerator::copyGraph(const csrGraph &someGraph)
+{
+    graph = someGraph;
+    numNodes = graph.getNumNodes();
+    buildBitRows();
+    buildCloseDistances();
+
+    addVertToPathQueue();
+}
+
+// Scanning a bit row costs numWords words no matter how many neighbors there are,
+// while the csrGraph costs about the out degree. Only use the bit rows when a row
+// is at most a few times the average out degree; this also bounds their memory to
+// a small multiple of the csrGraph.
+void cycleGenerator::buildBitRows()
+{
+    numWords = bitWords(numNodes);
+    pathMask.assign(numWords,0);
+    adjBits.clear();
+    useBitRows = 0;
+    if (numNodes == 0 || numWords > 2*(graph.getNumEdges()/numNodes) + 2)
+    {
+        return;
+    }
+
+    useBitRows = 1;
+    adjBits.assign((size_t)numNodes*numWords,0);
+    for (int i=0;i<numNodes;i++)
+    {
+        for (const int *nit=graph.outBegin(i);nit!=graph.outEnd(i);nit++)
+        {
+            setBit(adjBits.data() + (size_t)i*numWords, *nit);
+        }
+    }
+}
+
+// A reverse breadth first search from each head h over the nodes above h, stopping
+// at distance cycleLengthMax-1. A path of length k from h can only close into a
+// cycle of length at most cycleLengthMax through v if k + (distance from v to h) is
+// at most cycleLengthMax, which only the nodes found here can satisfy.
+void cycleGenerator::buildCloseDistances()
+{
+    closeOffsets.clear();
+    closeNodes.clear();
+    closeDist.clear();
+    if (cycleLengthMax == -1 || numNodes == 0)
+    {
+        return;
+    }
+    graph.buildReverse();
+
+    closeOffsets.assign(numNodes+1,0);
+    vector <int> dist(numNodes,-1);
+    vector <int> queue;
+    vector <pair <int,int> > found;
+    for (int h=0;h<numNodes;h++)
+    {
+        queue.assign(1,h);
+        dist[h] = 0;
+        for (int pos=0;pos<queue.size();pos++)
+        {
+            int v = queue[pos];
+            if (dist[v] + 1 >= cycleLengthMax)
+            {
+                break;
+            }
+            for (const int *nit=graph.inBegin(v);nit!=graph.inEnd(v);nit++)
+            {
+                if (*nit > h && dist[*nit] == -1)
+                {
+                    dist[*nit] = dist[v] + 1;
+                    queue.push_back(*nit);
+                }
+            }
+        }
+
+        found.clear();
+        for (int pos=1;pos<queue.size();pos++)
+        {
+            found.push_back(pair <int,int> (queue[pos],dist[queue[pos]]));
+        }
+        sort(found.begin(),found.end());
+        for (int k=0;k<found.size();k++)
+        {
+            closeNodes.push_back(found[k].first);
+            closeDist.push_back(found[k].second);
+        }
+        closeOffsets[h+1] = closeNodes.size();
+        for (int pos=0;pos<queue.size();pos++)
+        {
+            dist[queue[pos]] = -1;
+        }
+    }
+}
+
+int cycleGenerator::closeDistance(int head, int v)
+{
+    const int *first = closeNodes.data() + closeOffsets[head];
+    const int *last = closeNodes.data() + closeOffsets[head+1];
+    const int *nit = lower_bound(first,last,v);
+    if (nit == last || *nit != v)
+    {
+        return cycleLengthMax;
+    }
+    return closeDist[nit - closeNodes.data()];
+}
+
+void cycleGenerator::init()
+{
+    hashBiDirectedCycles=0;
+    numNodes = 0;
+    numWords = 0;
+    useBitRows = 0;
+    pathQueueFront = 0;
+    pathQueueLength = 0;
+    oneStepCalls=0;
+    numThreads=1;
+    threadPool = NULL;
+    cycleLengthMin=1;
+    cycleLengthMax=-1;
+    peakQueueRecords = 0;
+    duplicateCycles = 0;
+    cyclesReturned = 0;
+    cyclesFoundNodes = 0;
+    progressEverySteps = 0;
+    nextProgressStep = 0;
+    memoryLimit = 0;
+    spillDir = "/tmp";
+    spillNodeBytes = 4;
+    spillRead = NULL;
+    spillWrite = NULL;
+    spillLength = 0;
+    spillReadLeft = 0;
+    spillWriteCount = 0;
+    spillFailed = 0;
+}
+
+
+void cycleGenerator::print () // Prints the adj matrix,
+{
+    if (numNodes != 0)
+    {
+        graph.print();
+    }
+}
+
+void cycleGenerator::clear ()
+{
+    graph.clear();
+    numNodes = 0;
+    numWords = 0;
+    useBitRows = 0;
+    adjBits.clear();
+    pathMask.clear();
+    pathQueue.clear();
+    pathQueueFront = 0;
+    pathQueueLength = 0;
+    cyclesFound.clear();
+    uniqBiDirectedCycles.clear();
+    closeOffsets.clear();
+    closeNodes.clear();
+    closeDist.clear();
+    oneStepCalls=0;
+    peakQueueRecords = 0;
+    duplicateCycles = 0;
+    cyclesReturned = 0;
+    cyclesFoundNodes = 0;
+    cyclesByLength.clear();
+    secondsByLength.clear();
+    nextProgressStep = progressEverySteps;
+    closeSpillFiles();
+    spillFailed = 0;
+}
+
+void cycleGenerator::addVertToPathQueue()
+{
+    pathRecord newRecord;
+    for (int i=0;i<numNodes;i++)
+    {
+        newRecord.parent = -1;
+        newRecord.tail = i;
+        newRecord.head = i;
+        newRecord.length = 1;
+        newRecord.pathBits = numNodes <= 64 ? ((uint64_t)1) << i : 0;
+        pathQueue.push_back(newRecord);
+    }
+}
+
+void cycleGenerator::getQueuedPath(int index, list <int> &path)
+{
+    path.clear();
+    for (;index!=-1;index=pathQueue[index].parent)
+    {
+        path.push_front(pathQueue[index].tail);
+    }
+}
+
+// Records are only ever appended after their parent, so one backward pass marks
+// every ancestor of the queued paths and one forward pass moves them down.
+void cycleGenerator::compactPathQueue()
+{
+    vector <int> newIndex(pathQueue.size(),-1);
+    for (int i=pathQueue.size()-1;i>=0;i--)
+    {
+        if (i >= pathQueueFront || newIndex[i] == 0)
+        {
+            newIndex[i] = 0; // Live
+            if (pathQueue[i].parent != -1)
+            {
+                newIndex[pathQueue[i].parent] = 0;
+            }
+        }
+    }
+
+    int numLive = 0;
+    int newFront = -1;
+    for (int i=0;i<pathQueue.size();i++)
+    {
+        if (newIndex[i] == -1)
+        {
+            continue;
+        }
+        if (i >= pathQueueFront && newFront == -1)
+        {
+            newFront = numLive;
+        }
+        newIndex[i] = numLive;
+        pathQueue[numLive] = pathQueue[i];
+        if (pathQueue[numLive].parent != -1)
+        {
+            pathQueue[numLive].parent = newIndex[pathQueue[numLive].parent];
+        }
+        numLive++;
+    }
+    pathQueue.resize(numLive);
+    pathQueueFront = newFront == -1 ? numLive : newFront;
+}
+
+void cycleGenerator::startPath()
+{
+    if (pathQueue[pathQueueFront].length != pathQueueLength)
+    {
+        // Starting on the next length. If most of the records are dead ends drop them.
+        endLevel();
+        pathQueueLength = pathQueue[pathQueueFront].length;
+        if (pathQueueFront > pathQueue.size() - pathQueueFront)
+        {
+            compactPathQueue();
+        }
+    }
+}
+
+// Adds the time spent on the paths of length pathQueueLength to secondsByLength.
+void cycleGenerator::endLevel()
+{
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if (pathQueueLength == 0)
+    {
+        runStartTime = now;
+    }
+    else
+    {
+        if (secondsByLength.size() <= pathQueueLength)
+        {
+            secondsByLength.resize(pathQueueLength+1,0);
+        }
+        secondsByLength[pathQueueLength] += chrono::duration <double> (now - levelStartTime).count();
+    }
+    levelStartTime = now;
+}
+
+// The cycle is written into cycleNodes, which is only allocated once, and
+// bi-directed cycles are looked up in place. A list is only built for a cycle
+// that is returned.
+void cycleGenerator::addCycle(int index)
+{
+    int length = pathQueue[index].length;
+    cycleNodes.resize(length);
+    for (int k=length-1;k>=0;k--)
+    {
+        cycleNodes[k] = pathQueue[index].tail;
+        index = pathQueue[index].parent;
+    }
+    addCycle(cycleNodes.data(),length);
+}
+
+void cycleGenerator::addCycle(const int *path, int length)
+{
+    // There exists a path. Add it to the cycle queue
+    if (hashBiDirectedCycles == 1 && length > 2 && isCycleBiDirected(path,length) == 1)
+    {
+        // If we are hashing bidirected cycles, add it to hash.
+        // If a representative of this cycle is already in our list skip it.
+        if (uniqBiDirectedCycles.insert(path,length) == 0)
+        {
+            duplicateCycles++;
+            return;
+        }
+    }
+    if (cycleLengthMin <= length)
+    {
+        cyclesFound.push_back(list <int> (path,path+length));
+        cyclesFoundNodes += length;
+        if (cyclesByLength.size() <= length)
+        {
+            cyclesByLength.resize(length+1,0);
+        }
+        cyclesByLength[length]++;
+    }
+}
+
+// Try to add all possible paths of length k+1 using the path
+// where the new vertex is larger than the head and not on the path.
+// mask must be numWords words of 0's. It is left that way.
+void cycleGenerator::extendPath(int index, uint64_t *mask, vector <pathRecord> &newPaths)
+{
+    pathRecord curRecord = pathQueue[index]; // A copy, newPaths may be pathQueue
+    int head = curRecord.head;
+    int tail = curRecord.tail;
+    int bounded = cycleLengthMax != -1 ? 1 : 0;
+    if (bounded == 1 && curRecord.length >= cycleLengthMax)
+    {
+        return;
+    }
+
+    if (numNodes <= 64)
+    {
+        mask[0] = curRecord.pathBits;
+    }
+    else
+    {
+        for (int i=index;i!=-1;i=pathQueue[i].parent)
+        {
+            setBit(mask,pathQueue[i].tail);
+        }
+    }
+
+    pathRecord newRecord;
+    newRecord.parent = index;
+    newRecord.head = head;
+    newRecord.length = curRecord.length + 1;
+    if (useBitRows == 1)
+    {
+        // The candidates are row[tail] & ~mask restricted to nodes > head.
+        const uint64_t *row = adjBits.data() + (size_t)tail*numWords;
+        int w = (head+1) >> 6;
+        uint64_t aboveHead = (~(uint64_t)0) << ((head+1) & 63);
+        for (;w<numWords;w++)
+        {
+            uint64_t candidates = row[w] & ~mask[w] & aboveHead;
+            aboveHead = ~(uint64_t)0;
+            while (candidates != 0)
+            {
+                uint64_t lowBit = candidates & (~candidates + 1);
+                candidates &= candidates - 1;
+                newRecord.tail = (w << 6) + lowestBit(lowBit);
+                if (bounded == 1 && curRecord.length + closeDistance(head,newRecord.tail) > cycleLengthMax)
+                {
+                    continue;
+                }
+                newRecord.pathBits = numNodes <= 64 ? curRecord.pathBits | lowBit : 0;
+                newPaths.push_back(newRecord);
+            }
+        }
+    }
+    else
+    {
+        // The neighbors are sorted so start with the first one larger than head.
+        const int *nit = upper_bound(graph.outBegin(tail),graph.outEnd(tail),head);
+        for (;nit!=graph.outEnd(tail);nit++)
+        {
+            int i = *nit;
+            if (testBit(mask,i) == 0 &&
+                (bounded == 0 || curRecord.length + closeDistance(head,i) <= cycleLengthMax))
+            {
+                newRecord.tail = i;
+                newRecord.pathBits = numNodes <= 64 ? curRecord.pathBits | (((uint64_t)1) << i) : 0;
+                newPaths.push_back(newRecord);
+            }
+        }
+    }
+
+    if (numNodes <= 64)
+    {
+        mask[0] = 0;
+    }
+    else
+    {
+        for (int i=index;i!=-1;i=pathQueue[i].parent)
+        {
+            clearBit(mask,pathQueue[i].tail);
+        }
+    }
+}
+
+int cycleGenerator::oneStep ()
+{
+    //cout << "[cycleGenerator::oneStep] pathQueue.size() = " << pathQueue.size();
+    //cout << " cyclesFound.size() = " << cyclesFound.size() << endl;
+    if (spillFailed == 1)
+    {
+        return 0;
+    }
+    oneStepCalls++;
+
+    if (pathQueueFront < pathQueue.size())
+    {
+        startPath();
+        if (spillNeeded() == 1)
+        {
+            spillPathQueue();
+            if (spillFailed == 1)
+            {
+                return 0;
+            }
+            if (spillRead != NULL)
+            {
+                return spilledStep();
+            }
+        }
+        int curIndex = pathQueueFront;
+        pathQueueFront++;
+
+        // Search for cycles using this path.
+        if (pathQueue[curIndex].length > 1 && hasEdge(pathQueue[curIndex].tail,pathQueue[curIndex].head) == 1)
+        {
+            addCycle(curIndex);
+        }
+
+        extendPath(curIndex, pathMask.data(), pathQueue);
+        checkProgress();
+        return 1;
+    }
+    if (spillRead != NULL)
+    {
+        return spilledStep();
+    }
+
+    if (pathQueueLength != 0)
+    {
+        // All paths are done.
+        endLevel();
+        pathQueueLength = 0;
+    }
+    return 0;
+}
+
+// Fewer queued paths of the current length than this are extended one at a time.
+const int PARALLEL_LEVEL_MIN = 1024;
+// At most this many paths are extended by one call of expandLevel, so nextCycle
+// does not run far past the cycle it is asked for.
+const int PARALLEL_LEVEL_BATCH = 65536;
+
+// The next paths of the current length are cut into chunks, in order. A chunk is
+// extended by one task into its own buffers: the new paths, and the indices of the
+// paths that close a cycle. Afterwards the buffers are joined in chunk order, which
+// gives the same pathQueue and cyclesFound as calling oneStep on each path.
+int cycleGenerator::expandLevel()
+{
+    if (numThreads <= 1 || spillFailed == 1 || pathQueueFront == pathQueue.size())
+    {
+        return 0;
+    }
+    startPath();
+
+    pathRecord levelEndRecord;
+    levelEndRecord.length = pathQueueLength + 1;
+    int levelEnd = lower_bound(pathQueue.begin()+pathQueueFront,pathQueue.end(),levelEndRecord,
+                               pathRecordShorter()) - pathQueue.begin();
+    int levelStart = pathQueueFront;
+    int numPaths = levelEnd - levelStart;
+    if (numPaths < PARALLEL_LEVEL_MIN)
+    {
+        return 0;
+    }
+    numPaths = min(numPaths,PARALLEL_LEVEL_BATCH);
+    // Every path can grow into numNodes new ones, and they all have to fit in what is
+    // left of half the limit and of PATH_QUEUE_MAX_RECORDS. Otherwise leave it to
+    // oneStep to spill in time.
+    long long recordsLeft = (long long)PATH_QUEUE_MAX_RECORDS - (long long)pathQueue.size();
+    if (memoryLimit != 0)
+    {
+        recordsLeft = min(recordsLeft,(long long)(memoryLimit/2/sizeof(pathRecord)) - (long long)pathQueue.size());
+    }
+    numPaths = (int)min((long long)numPaths,max(recordsLeft,0LL)/numNodes);
+    if (numPaths < PARALLEL_LEVEL_MIN)
+    {
+        return 0;
+    }
+
+    int numChunks = min(numThreads*8,numPaths/64);
+    vector <vector <pathRecord> > newPaths(numChunks);
+    vector <vector <int> > closedPaths(numChunks);
+    for (int chunk=0;chunk<numChunks;chunk++)
+    {
+        threadPool->addTask([&, chunk]()
+        {
+            int first = levelStart + (long)numPaths*chunk/numChunks;
+            int last = levelStart + (long)numPaths*(chunk+1)/numChunks;
+            vector <uint64_t> mask(numWords,0);
+            for (int index=first;index<last;index++)
+            {
+                if (pathQueue[index].length > 1 && hasEdge(pathQueue[index].tail,pathQueue[index].head) == 1)
+                {
+                    closedPaths[chunk].push_back(index);
+                }
+                extendPath(index, mask.data(), newPaths[chunk]);
+            }
+        });
+    }
+    threadPool->wait();
+
+    for (int chunk=0;chunk<numChunks;chunk++)
+    {
+        for (int k=0;k<closedPaths[chunk].size();k++)
+        {
+            addCycle(closedPaths[chunk][k]);
+        }
+        pathQueue.insert(pathQueue.end(),newPaths[chunk].begin(),newPaths[chunk].end());
+        vector <pathRecord> ().swap(newPaths[chunk]);
+    }
+    pathQueueFront = levelStart + numPaths;
+    oneStepCalls += numPaths;
+    checkProgress();
+    return 1;
+}
+
+list <int> cycleGenerator::nextCycle()
+{
+    list <int> retList;
+    if (numNodes == 0 || (pathQueueFront == pathQueue.size() && spillRead == NULL && cyclesFound.size() == 0))
+    {
+        // either no adj matrix, or we have exhausted all the cycles.
+        return retList;
+    }
+    while (cyclesFound.size() == 0 && (expandLevel() == 1 || oneStep() == 1))
+    {
+    }
+    if (cyclesFound.size() == 0)
+    {
+        // We have exhausted all the cycles.
+        return retList;
+    }
+    retList.swap(cyclesFound.front());
+    cyclesFound.pop_front();
+    cyclesFoundNodes -= retList.size();
+    cyclesReturned++;
+
+    return retList;
+}
+
+void cycleGenerator::checkProgress()
+{
+    peakQueueRecords = max(peakQueueRecords,(long long)pathQueue.size());
+    if (progressCallback && oneStepCalls >= nextProgressStep)
+    {
+        nextProgressStep = oneStepCalls + progressEverySteps;
+        progressCallback(getStats());
+    }
+}
+
+cycleGeneratorStats cycleGenerator::getStats()
+{
+    cycleGeneratorStats stats;
+    stats.pathLength = pathQueueLength;
+    stats.steps = oneStepCalls;
+    stats.queuedPaths = pathQueue.size() - pathQueueFront + spillReadLeft + spillWriteCount;
+    stats.queueRecords = pathQueue.size();
+    stats.peakQueueRecords = max(peakQueueRecords,(long long)pathQueue.size());
+    stats.duplicateCycles = duplicateCycles;
+    stats.cyclesReturned = cyclesReturned;
+    // A list node holds its value and two pointers.
+    stats.bytesHeld = pathQueue.capacity()*sizeof(pathRecord) +
+                      cyclesFoundNodes*(sizeof(int) + 2*sizeof(void *)) +
+                      cyclesFound.size()*(sizeof(list <int>) + 2*sizeof(void *)) +
+                      uniqBiDirectedCycles.bytes() +
+                      adjBits.capacity()*sizeof(uint64_t) +
+                      (closeOffsets.capacity() + closeNodes.capacity() + closeDist.capacity())*sizeof(int);
+    stats.bytesSpilled = (spillReadLeft*spillLength + spillWriteCount*(spillLength+1))*spillNodeBytes;
+    stats.cyclesByLength = cyclesByLength;
+    stats.secondsByLength = secondsByLength;
+    stats.seconds = 0;
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if (pathQueueLength != 0)
+    {
+        // Add the time of the length being extended now.
+        if (stats.secondsByLength.size() <= pathQueueLength)
+        {
+            stats.secondsByLength.resize(pathQueueLength+1,0);
+        }
+        stats.secondsByLength[pathQueueLength] += chrono::duration <double> (now - levelStartTime).count();
+    }
+    if (oneStepCalls != 0)
+    {
+        stats.seconds = chrono::duration <double> (now - runStartTime).count();
+    }
+    return stats;
+}
+
+void cycleGenerator::setProgressCallback(const function <void (const cycleGeneratorStats &)> &callback, long long everySteps)
+{
+    progressCallback = callback;
+    progressEverySteps = max(1LL,everySteps);
+    nextProgressStep = oneStepCalls + progressEverySteps;
+}
+
+int cycleGenerator::setMemoryLimit(size_t bytes, const char *tempDir)
+{
+    memoryLimit = 0;
+    spillDir = tempDir == NULL ? "/tmp" : tempDir;
+    FILE *testFile = openSpillFile();
+    if (testFile == NULL)
+    {
+        return 0;
+    }
+    fclose(testFile);
+    memoryLimit = bytes;
+    return 1;
+}
+
+int cycleGenerator::spillError()
+{
+    return spillFailed;
+}
+
+// Checked before a path is extended, so pathQueue is spilled before it grows past
+// the limit. An extension adds at most numNodes records. Without a limit it is still
+// spilled before the records can no longer be indexed with an int.
+int cycleGenerator::spillNeeded()
+{
+    if (spillRead != NULL)
+    {
+        return 0;
+    }
+    if (pathQueue.size() + numNodes > PATH_QUEUE_MAX_RECORDS)
+    {
+        return 1;
+    }
+    if (memoryLimit == 0 || pathQueue.size() + numNodes <= pathQueue.capacity())
+    {
+        return 0;
+    }
+    return 2*pathQueue.capacity()*sizeof(pathRecord) > memoryLimit ? 1 : 0;
+}
+
+FILE *cycleGenerator::openSpillFile()
+{
+    string fileName = spillDir + "/cyclegenXXXXXX";
+    vector <char> nameBuffer(fileName.begin(),fileName.end());
+    nameBuffer.push_back(0);
+    int fd = mkstemp(nameBuffer.data());
+    if (fd == -1)
+    {
+        return NULL;
+    }
+    unlink(nameBuffer.data());
+    FILE *spillFile = fdopen(fd,"w+b");
+    if (spillFile == NULL)
+    {
+        close(fd);
+        return NULL;
+    }
+    setvbuf(spillFile,NULL,_IOFBF,1 << 20);
+    return spillFile;
+}
+
+void cycleGenerator::closeSpillFiles()
+{
+    if (spillRead != NULL)
+    {
+        fclose(spillRead);
+    }
+    if (spillWrite != NULL)
+    {
+        fclose(spillWrite);
+    }
+    spillRead = NULL;
+    spillWrite = NULL;
+    spillLength = 0;
+    spillReadLeft = 0;
+    spillWriteCount = 0;
+}
+
+int cycleGenerator::writeSpilledPath(FILE *spillFile, const int *path, int length)
+{
+    if (spillNodeBytes == 4)
+    {
+        return fwrite(path,sizeof(int),length,spillFile) == length ? 1 : 0;
+    }
+    spillBuffer.resize(2*length);
+    uint16_t *packed = (uint16_t *)spillBuffer.data();
+    for (int k=0;k<length;k++)
+    {
+        packed[k] = (uint16_t)path[k];
+    }
+    return fwrite(packed,sizeof(uint16_t),length,spillFile) == length ? 1 : 0;
+}
+
+int cycleGenerator::readSpilledPath(FILE *spillFile, int *path, int length)
+{
+    if (spillNodeBytes == 4)
+    {
+        return fread(path,sizeof(int),length,spillFile) == length ? 1 : 0;
+    }
+    spillBuffer.resize(2*length);
+    uint16_t *packed = (uint16_t *)spillBuffer.data();
+    if (fread(packed,sizeof(uint16_t),length,spillFile) != length)
+    {
+        return 0;
+    }
+    for (int k=0;k<length;k++)
+    {
+        path[k] = packed[k];
+    }
+    return 1;
+}
+
+// The queued paths all have length pathQueueLength or one more. The shorter ones go
+// to spillRead and the longer ones, their extensions so far, start spillWrite, so
+// reading the files gives the paths in queue order.
+void cycleGenerator::spillPathQueue()
+{
+    spillRead = openSpillFile();
+    spillWrite = openSpillFile();
+    if (spillRead == NULL || spillWrite == NULL)
+    {
+        closeSpillFiles();
+        if (pathQueue.size() + numNodes > PATH_QUEUE_MAX_RECORDS)
+        {
+            // The queue can not grow any more in memory.
+            spillFailed = 1;
+            return;
+        }
+        // Carry on in memory.
+        memoryLimit = 0;
+        return;
+    }
+    spillNodeBytes = numNodes <= 65536 ? 2 : 4;
+    spillLength = pathQueueLength;
+    spillPath.resize(spillLength+2);
+
+    int written = 1;
+    for (int i=pathQueueFront;i<pathQueue.size() && written==1;i++)
+    {
+        int length = pathQueue[i].length;
+        for (int k=length-1,index=i;k>=0;k--,index=pathQueue[index].parent)
+        {
+            spillPath[k] = pathQueue[index].tail;
+        }
+        if (length == spillLength)
+        {
+            written = writeSpilledPath(spillRead,spillPath.data(),length);
+            spillReadLeft++;
+        }
+        else
+        {
+            written = writeSpilledPath(spillWrite,spillPath.data(),length);
+            spillWriteCount++;
+        }
+    }
+    vector <pathRecord> ().swap(pathQueue);
+    pathQueueFront = 0;
+    if (written == 0 || fflush(spillRead) != 0)
+    {
+        spillFailed = 1;
+        closeSpillFiles();
+        return;
+    }
+    rewind(spillRead);
+}
+
+int cycleGenerator::spilledStep()
+{
+    while (spillReadLeft == 0)
+    {
+        if (spillWriteCount == 0)
+        {
+            // All paths are done.
+            closeSpillFiles();
+            endLevel();
+            pathQueueLength = 0;
+            return 0;
+        }
+        // Go on with the next length.
+        fclose(spillRead);
+        spillRead = spillWrite;
+        spillWrite = openSpillFile();
+        if (spillWrite == NULL || fflush(spillRead) != 0)
+        {
+            spillFailed = 1;
+            closeSpillFiles();
+            return 0;
+        }
+        rewind(spillRead);
+        spillReadLeft = spillWriteCount;
+        spillWriteCount = 0;
+        endLevel();
+        spillLength++;
+        pathQueueLength = spillLength;
+        spillPath.resize(spillLength+1);
+    }
+
+    int length = spillLength;
+    if (readSpilledPath(spillRead,spillPath.data(),length) == 0)
+    {
+        spillFailed = 1;
+        closeSpillFiles();
+        return 0;
+    }
+    spillReadLeft--;
+
+    if (length > 1 && hasEdge(spillPath[length-1],spillPath[0]) == 1)
+    {
+        addCycle(spillPath.data(),length);
+    }
+    if (cycleLengthMax == -1 || length < cycleLengthMax)
+    {
+        extendSpilledPath(length);
+    }
+    checkProgress();
+    return spillFailed == 1 ? 0 : 1;
+}
+
+// The same extensions as extendPath, written out as whole paths.
+void cycleGenerator::extendSpilledPath(int length)
+{
+    int head = spillPath[0];
+    int tail = spillPath[length-1];
+    int bounded = cycleLengthMax != -1 ? 1 : 0;
+    uint64_t *mask = pathMask.data();
+    for (int k=0;k<length;k++)
+    {
+        setBit(mask,spillPath[k]);
+    }
+
+    int written = 1;
+    if (useBitRows == 1)
+    {
+        const uint64_t *row = adjBits.data() + (size_t)tail*numWords;
+        int w = (head+1) >> 6;
+        uint64_t aboveHead = (~(uint64_t)0) << ((head+1) & 63);
+        for (;w<numWords && written==1;w++)
+        {
+            uint64_t candidates = row[w] & ~mask[w] & aboveHead;
+            aboveHead = ~(uint64_t)0;
+            while (candidates != 0 && written == 1)
+            {
+                int i = (w << 6) + lowestBit(candidates);
+                candidates &= candidates - 1;
+                if (bounded == 0 || length + closeDistance(head,i) <= cycleLengthMax)
+                {
+                    spillPath[length] = i;
+                    written = writeSpilledPath(spillWrite,spillPath.data(),length+1);
+                    spillWriteCount++;
+                }
+            }
+        }
+    }
+    else
+    {
+        const int *nit = upper_bound(graph.outBegin(tail),graph.outEnd(tail),head);
+        for (;nit!=graph.outEnd(tail) && written==1;nit++)
+        {
+            int i = *nit;
+            if (testBit(mask,i) == 0 &&
+                (bounded == 0 || length + closeDistance(head,i) <= cycleLengthMax))
+            {
+                spillPath[length] = i;
+                written = writeSpilledPath(spillWrite,spillPath.data(),length+1);
+                spillWriteCount++;
+            }
+        }
+    }
+
+    for (int k=0;k<length;k++)
+    {
+        clearBit(mask,spillPath[k]);
+    }
+    if (written == 0)
+    {
+        spillFailed = 1;
+        closeSpillFiles();
+    }
+}
+
+// A checkpoint is the 8 bytes "CYCLEGEN" and the format version, then, in the byte
+// order of the machine that wrote it:
+//   numNodes, numEdges, the numNodes+1 offsets and numEdges neighbors of the graph,
+//   hashBiDirectedCycles, cycleLengthMin, cycleLengthMax,
+//   oneStepCalls, peakQueueRecords, duplicateCycles, cyclesReturned,
+//   cyclesByLength and secondsByLength, each as its size and entries, the seconds
+//   since the first step and since the current length was started,
+//   the size and front of pathQueue, pathQueueLength, and parent, tail, head and
+//   length of every record,
+//   1 if the queue is spilled, spillLength, spillNodeBytes, spillReadLeft,
+//   spillWriteCount, and the paths still in the two files as they are there,
+//   the number of cycles in cyclesFound, and the length and nodes of each,
+//   and uniqBiDirectedCycles (see cycleHashSet::save).
+// Counts and sizes are 64 bit, seconds are doubles and the rest are 32 bit ints.
+const char CHECKPOINT_MAGIC[] = "CYCLEGEN";
+const int CHECKPOINT_VERSION = 1;
+
+int cycleGenerator::save(const char *fileName)
+{
+    string tempName = string(fileName) + ".tmp";
+    FILE *out = fopen(tempName.c_str(),"wb");
+    if (out == NULL)
+    {
+        return 0;
+    }
+
+    int ok = 1;
+    auto put = [&](const void *data, size_t size)
+    {
+        if (ok == 1 && size != 0 && fwrite(data,1,size,out) != size)
+        {
+            ok = 0;
+        }
+    };
+    auto putInt = [&](int x) { put(&x,sizeof(int)); };
+    auto putLong = [&](long long x) { put(&x,sizeof(long long)); };
+    // Copies size bytes of spillFile starting at start (-1 is where it is now), then
+    // goes back to where it was.
+    auto putSpilled = [&](FILE *spillFile, long start, long long size)
+    {
+        long pos = ftell(spillFile);
+        if (pos == -1 || (start != -1 && fseek(spillFile,start,SEEK_SET) != 0))
+        {
+            ok = 0;
+        }
+        vector <char> buffer(1 << 20);
+        while (size > 0 && ok == 1)
+        {
+            size_t chunk = (size_t)min(size,(long long)buffer.size());
+            if (fread(buffer.data(),1,chunk,spillFile) != chunk)
+            {
+                ok = 0;
+            }
+            put(buffer.data(),chunk);
+            size -= chunk;
+        }
+        if (pos == -1 || fseek(spillFile,pos,SEEK_SET) != 0)
+        {
+            ok = 0;
+        }
+    };
+
+    put(CHECKPOINT_MAGIC,8);
+    putInt(CHECKPOINT_VERSION);
+    putInt(numNodes);
+    putInt(graph.getNumEdges());
+    for (int i=0;i<=numNodes && numNodes!=0;i++)
+    {
+        putInt(graph.outOffset(i));
+    }
+    if (numNodes != 0)
+    {
+        put(graph.outBegin(0),graph.getNumEdges()*sizeof(int));
+    }
+    putInt(hashBiDirectedCycles);
+    putInt(cycleLengthMin);
+    putInt(cycleLengthMax);
+
+    putLong(oneStepCalls);
+    putLong(peakQueueRecords);
+    putLong(duplicateCycles);
+    putLong(cyclesReturned);
+    putLong(cyclesByLength.size());
+    put(cyclesByLength.data(),cyclesByLength.size()*sizeof(long long));
+    putLong(secondsByLength.size());
+    put(secondsByLength.data(),secondsByLength.size()*sizeof(double));
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    double runSeconds = oneStepCalls != 0 ? chrono::duration <double> (now - runStartTime).count() : 0;
+    double levelSeconds = pathQueueLength != 0 ? chrono::duration <double> (now - levelStartTime).count() : 0;
+    put(&runSeconds,sizeof(double));
+    put(&levelSeconds,sizeof(double));
+
+    putLong(pathQueue.size());
+    putLong(pathQueueFront);
+    putInt(pathQueueLength);
+    for (int i=0;i<pathQueue.size();i++)
+    {
+        putInt(pathQueue[i].parent);
+        putInt(pathQueue[i].tail);
+        putInt(pathQueue[i].head);
+        putInt(pathQueue[i].length);
+    }
+
+    putInt(spillRead != NULL ? 1 : 0);
+    if (spillRead != NULL)
+    {
+        putInt(spillLength);
+        putInt(spillNodeBytes);
+        putLong(spillReadLeft);
+        putLong(spillWriteCount);
+        putSpilled(spillRead,-1,spillReadLeft*spillLength*spillNodeBytes);
+        putSpilled(spillWrite,0,spillWriteCount*(spillLength+1)*spillNodeBytes);
+    }
+
+    putLong(cyclesFound.size());
+    for (list < list <int> >::iterator llit=cyclesFound.begin();llit!=cyclesFound.end();llit++)
+    {
+        putInt(llit->size());
+        for (list <int>::iterator lit=llit->begin();lit!=llit->end();lit++)
+        {
+            putInt(*lit);
+        }
+    }
+    if (ok == 1)
+    {
+        ok = uniqBiDirectedCycles.save(out);
+    }
+
+    if (fclose(out) != 0 || ok == 0 || rename(tempName.c_str(),fileName) != 0)
+    {
+        remove(tempName.c_str());
+        return 0;
+    }
+    return 1;
+}
+
+int cycleGenerator::load(const char *fileName)
+{
+    clear();
+    FILE *in = fopen(fileName,"rb");
+    if (in == NULL)
+    {
+        return 0;
+    }
+
+    int ok = 1;
+    auto get = [&](void *data, size_t size)
+    {
+        if (ok == 1 && size != 0 && fread(data,1,size,in) != size)
+        {
+            ok = 0;
+        }
+    };
+    auto getInt = [&]() { int x = 0; get(&x,sizeof(int)); return x; };
+    auto getLong = [&]() { long long x = 0; get(&x,sizeof(long long)); return x; };
+    // Copies the next size bytes of the checkpoint to a new spill file.
+    auto getSpilled = [&](long long size)
+    {
+        FILE *spillFile = openSpillFile();
+        if (spillFile == NULL || size < 0)
+        {
+            ok = 0;
+            return spillFile;
+        }
+        vector <char> buffer(1 << 20);
+        while (size > 0 && ok == 1)
+        {
+            size_t chunk = (size_t)min(size,(long long)buffer.size());
+            get(buffer.data(),chunk);
+            if (ok == 1 && fwrite(buffer.data(),1,chunk,spillFile) != chunk)
+            {
+                ok = 0;
+            }
+            size -= chunk;
+        }
+        return spillFile;
+    };
+
+    char magic[8];
+    get(magic,8);
+    if (ok == 0 || memcmp(magic,CHECKPOINT_MAGIC,8) != 0 || getInt() != CHECKPOINT_VERSION)
+    {
+        fclose(in);
+        return 0;
+    }
+
+    int someNumNodes = getInt();
+    int numEdges = getInt();
+    if (someNumNodes < 0 || numEdges < 0)
+    {
+        ok = 0;
+    }
+    if (ok == 1 && someNumNodes != 0)
+    {
+        vector <int> someOffsets(someNumNodes+1);
+        vector <int> someNeighbors(numEdges);
+        get(someOffsets.data(),someOffsets.size()*sizeof(int));
+        get(someNeighbors.data(),someNeighbors.size()*sizeof(int));
+        for (int i=0;i<someNumNodes && ok==1;i++)
+        {
+            ok = someOffsets[i] <= someOffsets[i+1] ? 1 : 0;
+        }
+        for (int k=0;k<numEdges && ok==1;k++)
+        {
+            ok = someNeighbors[k] >= 0 && someNeighbors[k] < someNumNodes ? 1 : 0;
+        }
+        if (ok == 1 && (someOffsets[0] != 0 || someOffsets[someNumNodes] != numEdges))
+        {
+            ok = 0;
+        }
+        if (ok == 1)
+        {
+            graph.fromCSR(someNumNodes,someOffsets,someNeighbors);
+            numNodes = someNumNodes;
+        }
+    }
+    hashBiDirectedCycles = getInt();
+    cycleLengthMin = getInt();
+    cycleLengthMax = getInt();
+
+    oneStepCalls = getLong();
+    peakQueueRecords = getLong();
+    duplicateCycles = getLong();
+    cyclesReturned = getLong();
+    long long count = getLong();
+    if (count < 0 || count > numNodes + 1)
+    {
+        ok = 0;
+    }
+    if (ok == 1)
+    {
+        cyclesByLength.resize(count);
+        get(cyclesByLength.data(),count*sizeof(long long));
+    }
+    count = getLong();
+    if (count < 0 || count > numNodes + 1)
+    {
+        ok = 0;
+    }
+    if (ok == 1)
+    {
+        secondsByLength.resize(count);
+        get(secondsByLength.data(),count*sizeof(double));
+    }
+    double runSeconds = 0;
+    double levelSeconds = 0;
+    get(&runSeconds,sizeof(double));
+    get(&levelSeconds,sizeof(double));
+
+    long long queueSize = getLong();
+    long long queueFront = getLong();
+    pathQueueLength = getInt();
+    if (queueSize < 0 || queueSize > INT_MAX || queueFront < 0 || queueFront > queueSize)
+    {
+        ok = 0;
+    }
+    if (ok == 1)
+    {
+        pathQueue.resize(queueSize);
+        pathQueueFront = queueFront;
+    }
+    for (int i=0;i<pathQueue.size() && ok==1;i++)
+    {
+        pathRecord &record = pathQueue[i];
+        record.parent = getInt();
+        record.tail = getInt();
+        record.head = getInt();
+        record.length = getInt();
+        if (record.parent < -1 || record.parent >= i || record.tail < 0 || record.tail >= numNodes ||
+            record.head < 0 || record.head >= numNodes || record.length < 1 || record.length > numNodes)
+        {
+            ok = 0;
+            break;
+        }
+        record.pathBits = 0;
+        if (numNodes <= 64)
+        {
+            record.pathBits = ((uint64_t)1) << record.tail;
+            if (record.parent != -1)
+            {
+                record.pathBits |= pathQueue[record.parent].pathBits;
+            }
+        }
+    }
+
+    if (getInt() == 1 && ok == 1)
+    {
+        spillLength = getInt();
+        spillNodeBytes = getInt();
+        spillReadLeft = getLong();
+        spillWriteCount = getLong();
+        if (spillLength < 1 || spillLength > numNodes || (spillNodeBytes != 2 && spillNodeBytes != 4))
+        {
+            ok = 0;
+        }
+        spillRead = getSpilled(spillReadLeft*spillLength*spillNodeBytes);
+        spillWrite = getSpilled(spillWriteCount*(spillLength+1)*spillNodeBytes);
+        if (ok == 1 && (fflush(spillRead) != 0 || fseek(spillRead,0,SEEK_SET) != 0))
+        {
+            ok = 0;
+        }
+        spillPath.resize(spillLength+2);
+    }
+
+    count = getLong();
+    for (long long k=0;k<count && ok==1;k++)
+    {
+        int length = getInt();
+        if (length < 1 || length > numNodes)
+        {
+            ok = 0;
+            break;
+        }
+        cycleNodes.resize(length);
+        get(cycleNodes.data(),length*sizeof(int));
+        for (int i=0;i<length;i++)
+        {
+            if (cycleNodes[i] < 0 || cycleNodes[i] >= numNodes)
+            {
+                ok = 0;
+            }
+        }
+        if (ok == 0)
+        {
+            break;
+        }
+        cyclesFound.push_back(list <int> (cycleNodes.begin(),cycleNodes.end()));
+        cyclesFoundNodes += length;
+    }
+    if (ok == 1)
+    {
+        ok = uniqBiDirectedCycles.load(in);
+    }
+    fclose(in);
+    if (ok == 0)
+    {
+        clear();
+        return 0;
+    }
+
+    buildBitRows();
+    buildCloseDistances();
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    runStartTime = now - chrono::duration_cast <chrono::steady_clock::duration> (chrono::duration <double> (runSeconds));
+    levelStartTime = now - chrono::duration_cast <chrono::steady_clock::duration> (chrono::duration <double> (levelSeconds));
+    nextProgressStep = oneStepCalls + progressEverySteps;
+    return 1;
+}
+
+int cycleGenerator::numOneStepCall()
+{
+    return oneStepCalls;
+}
+
+void cycleGenerator::setHashBiDirectedCycles(int x)
+{
+    hashBiDirectedCycles = x;
+}
+
+int cycleGenerator::isCycleBiDirected(const int *myCycle, int length)
+{
+    if (length <= 1 || numNodes == 0)
+    {
+        return 0;
+    }
+    for (int k=0;k<length;k++)
+    {
+        if (hasEdge(myCycle[(k+1) % length],myCycle[k]) == 0)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int cycleGenerator::isCycleBiDirected(list <int> myCycle)
+{
+    if (myCycle.size() <= 1 || numNodes == 0)
+    {
+        return 0;
+    }
+
+    list <int>::iterator tempLit;
+    list <int>::iterator lit = myCycle.begin();
+    tempLit = lit;
+    tempLit++;
+    for(;lit!=myCycle.end() && tempLit != myCycle.end();lit++)
+    {
+        //cout << "*lit: " << *lit << " *tempLit: " << *tempLit << endl;
+        if(hasEdge(*tempLit,*lit) == 0)
+        {
+            return 0;
+        }
+        tempLit++;
+    }
+    // Now lit is the last node
+    if (hasEdge(*(myCycle.begin()),*lit) == 0)
+    {
+        return 0;
+    }
+
+    return 1;
+}
+
+
+list <int> cycleGenerator::uniqueBiDirCycle(list <int> myList)
+{
+    //cout << "[cycleGenerator::uniqueBiDirCycle] ";
+    //printListInt(myList);
+
+    if (myList.size() <= 1 || isCycleBiDirected(myList) == 0)
+    {
+        return myList;
+    }
+
+    list <int> retList;
+
+    list <int>::iterator minVal;
+    list <int>::iterator tempLit;
+    list <int>::iterator lit=myList.begin();
+    int curMin = *lit;
+    minVal = lit;
+    // Find the min value;
+    for (;lit!=myList.end();lit++)
+    {
+        if (*lit < curMin )
+        {
+            minVal = lit;
+            curMin = *lit;
+        }
+    }
+    //cout << "Min val: " << *minVal << endl;
+
+    int reverseList = 0;
+    int minPlus,minMinus;
+    lit = minVal;
+    tempLit = minVal;
+    tempLit++;
+    if(lit == myList.begin())
+    {
+        lit++;
+        minPlus = *lit;
+        lit = myList.end();
+        lit--;
+        minMinus = *lit;
+    }
+    else if (tempLit == myList.end())
+    {
+        lit--;
+        minMinus = *lit;
+        lit = myList.begin();
+        minPlus = *lit;
+    }
+    else
+    {
+        lit++;
+        minPlus = *lit;
+        lit--;
+        minMinus = *lit;
+    }
+    //cout << "minPlus: " << minPlus << " minMinus: " << minMinus << endl;
+
+    if (minPlus > minMinus)
+    {
+        return uniqueCycle(revList(myList));
+    }
+    else
+    {
+        return uniqueCycle(myList);
+    }
+}
+
+int cycleGenerator::sizeUniqBiDirectedCycles()
+{
+    return uniqBiDirectedCycles.size();
+}
+
+void cycleGenerator::printUniqBiDirectedCycles()
+{
+    list <int> tempList;
+    for (int k=0;k<uniqBiDirectedCycles.size();k++)
+    {
+        uniqBiDirectedCycles.getCycle(k,tempList);
+        printListInt(tempList);
+    }
+
+}
+
+void cycleGenerator::setCycleLengthMin(int x)
+{
+    cycleLengthMin = x;
+}
+
+void cycleGenerator::setCycleLengthMax(int x)
+{
+    cycleLengthMax = x;
+    buildCloseDistances();
+}
+
+// The threads are started here once and kept until the next call, so expandLevel
+// does not start and join them for every batch.
+void cycleGenerator::setNumThreads(int x)
+{
+    if (threadPool != NULL && x == numThreads)
+    {
+        return;
+    }
+    numThreads = x;
+    delete threadPool;
+    threadPool = numThreads > 1 ? new graphThreadPool(numThreads) : NULL;
+}
+
+// Returns true if x is in myList.
+int isInList(int x, const list <int> &myList)
+{
+    list <int>::const_iterator lit;
+    for(lit = myList.begin();lit!=myList.end();lit++)
+    {
+        if (x == *lit)
+        {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+// Compares the two lists and returns 1 if they are equal.
+int listsEqual (list <int> listOne,list <int> listTwo)
+{
+    if (listOne.size() != listTwo.size())
+    {
+        return 0;
+    }
+    if (listOne.size() == 0 && listTwo.size() == 0)
+    {
+        return 1;
+    }
+    list <int>::iterator litOne, litTwo;
+    litOne = listOne.begin();
+    litTwo = listTwo.begin();
+    while (litOne != listOne.end() && litTwo != listTwo.end())
+    {
+        if (*litOne != *litTwo)
+        {
+            return 0;
+        }
+        litOne++;
+        litTwo++;
+    }
+    return 1;
+}
+
+// Returns a string of the list.
+// E.g. [1 3 2 5] would give "1,3,2,5"
+// Up to user to delete the string
+char * listToString(list <int> myList)
+{
+    int length = 0;
+    list <int>::iterator lit;
+    for(lit = myList.begin();lit!=myList.end();lit++)
+    {
+        length += snprintf(NULL,0,"%d,",*lit); // The number of characters with the comma
+    }
+    char *retString = new char[length+1]; //Null terminate
+    retString[0] = 0;
+
+    int curIndex = 0;
+    for(lit = myList.begin();lit!=myList.end();lit++)
+    {
+        if (curIndex != 0)
+        {
+            retString[curIndex++] = ',';
+        }
+        curIndex += sprintf(retString + curIndex,"%d",*lit); // This will null terminate
+    }
+
+    return retString;
+}
+
+// Finds where the canonical form of the cycle starts and which way it goes (1 or -1).
+void canonicalCycleStart(const int *cycle, int length, int &start, int &step)
+{
+    start = 0;
+    for (int k=1;k<length;k++)
+    {
+        if (cycle[k] < cycle[start])
+        {
+            start = k;
+        }
+    }
+    step = 1;
+    if (length > 2 && cycle[(start+1) % length] > cycle[(start+length-1) % length])
+    {
+        step = -1;
+    }
+}
+
+uint64_t hashCycle(const int *cycle, int length)
+{
+    int start, step;
+    canonicalCycleStart(cycle, length, start, step);
+
+    uint64_t retVal = 0xcbf29ce484222325ULL ^ (uint64_t)length;
+    int pos = start;
+    for (int k=0;k<length;k++)
+    {
+        retVal = (retVal ^ (uint32_t)cycle[pos]) * 0x100000001b3ULL;
+        pos += step;
+        if (pos == length)
+        {
+            pos = 0;
+        }
+        else if (pos < 0)
+        {
+            pos = length - 1;
+        }
+    }
+    // Mix the high bits down, the table uses the low bits.
+    retVal ^= retVal >> 33;
+    retVal *= 0xff51afd7ed558ccdULL;
+    retVal ^= retVal >> 33;
+    return retVal;
+}
+
+int cyclesEqual(const int *cycleOne, int lengthOne, const int *cycleTwo, int lengthTwo)
+{
+    if (lengthOne != lengthTwo)
+    {
+        return 0;
+    }
+    int startOne, stepOne, startTwo, stepTwo;
+    canonicalCycleStart(cycleOne, lengthOne, startOne, stepOne);
+    canonicalCycleStart(cycleTwo, lengthTwo, startTwo, stepTwo);
+    for (int k=0;k<lengthOne;k++)
+    {
+        if (cycleOne[startOne] != cycleTwo[startTwo])
+        {
+            return 0;
+        }
+        startOne = (startOne + stepOne + lengthOne) % lengthOne;
+        startTwo = (startTwo + stepTwo + lengthTwo) % lengthTwo;
+    }
+    return 1;
+}
+
+cycleHashSet::cycleHashSet()
+{
+    clear();
+}
+
+size_t cycleHashSet::bytes()
+{
+    return slotHash.capacity()*sizeof(uint64_t) + slotCycle.capacity()*sizeof(int) +
+           (cycleStart.capacity() + storage.capacity())*sizeof(int);
+}
+
+void cycleHashSet::clear()
+{
+    slotHash.assign(16,0);
+    slotCycle.assign(16,-1);
+    cycleStart.assign(1,0);
+    storage.clear();
+}
+
+// Linear probing. The table size is a power of 2.
+int cycleHashSet::findSlot(const int *cycle, int length, uint64_t hash)
+{
+    int mask = slotCycle.size() - 1;
+    int slot = hash & mask;
+    while (slotCycle[slot] != -1)
+    {
+        int k = slotCycle[slot];
+        if (slotHash[slot] == hash &&
+            cyclesEqual(cycle, length, storage.data() + cycleStart[k], cycleStart[k+1] - cycleStart[k]) == 1)
+        {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void cycleHashSet::grow()
+{
+    vector <uint64_t> oldHash;
+    vector <int> oldCycle;
+    oldHash.swap(slotHash);
+    oldCycle.swap(slotCycle);
+    slotHash.assign(oldHash.size()*2,0);
+    slotCycle.assign(oldCycle.size()*2,-1);
+    int mask = slotCycle.size() - 1;
+    for (int i=0;i<oldCycle.size();i++)
+    {
+        if (oldCycle[i] == -1)
+        {
+            continue;
+        }
+        int slot = oldHash[i] & mask;
+        while (slotCycle[slot] != -1)
+        {
+            slot = (slot + 1) & mask;
+        }
+        slotHash[slot] = oldHash[i];
+        slotCycle[slot] = oldCycle[i];
+    }
+}
+
+int cycleHashSet::insert(const int *cycle, int length)
+{
+    uint64_t hash = hashCycle(cycle, length);
+    int slot = findSlot(cycle, length, hash);
+    if (slotCycle[slot] != -1)
+    {
+        return 0;
+    }
+
+    // Store the canonical form.
+    int start, step;
+    canonicalCycleStart(cycle, length, start, step);
+    for (int k=0;k<length;k++)
+    {
+        storage.push_back(cycle[start]);
+        start = (start + step + length) % length;
+    }
+    slotHash[slot] = hash;
+    slotCycle[slot] = size();
+    cycleStart.push_back(storage.size());
+
+    if (2*size() > slotCycle.size())
+    {
+        grow();
+    }
+    return 1;
+}
+
+int cycleHashSet::save(FILE *out)
+{
+    long long numCycles = size();
+    long long numStored = storage.size();
+    return fwrite(&numCycles,sizeof(long long),1,out) == 1 &&
+           fwrite(&numStored,sizeof(long long),1,out) == 1 &&
+           fwrite(cycleStart.data(),sizeof(int),numCycles+1,out) == numCycles+1 &&
+           fwrite(storage.data(),sizeof(int),numStored,out) == numStored ? 1 : 0;
+}
+
+// The cycles are added again in the same order, so the set is as it was saved.
+int cycleHashSet::load(FILE *in)
+{
+    clear();
+    long long numCycles = 0;
+    long long numStored = 0;
+    if (fread(&numCycles,sizeof(long long),1,in) != 1 || fread(&numStored,sizeof(long long),1,in) != 1 ||
+        numCycles < 0 || numCycles > INT_MAX || numStored < 0 || numStored > INT_MAX)
+    {
+        return 0;
+    }
+    vector <int> someStart(numCycles+1);
+    vector <int> someStorage(numStored);
+    if (fread(someStart.data(),sizeof(int),numCycles+1,in) != numCycles+1 ||
+        fread(someStorage.data(),sizeof(int),numStored,in) != numStored ||
+        someStart[0] != 0 || someStart[numCycles] != numStored)
+    {
+        return 0;
+    }
+    for (int k=0;k<numCycles;k++)
+    {
+        if (someStart[k] >= someStart[k+1])
+        {
+            clear();
+            return 0;
+        }
+        insert(someStorage.data() + someStart[k],someStart[k+1] - someStart[k]);
+    }
+    return 1;
+}
+
+int cycleHashSet::contains(const int *cycle, int length)
+{
+    return slotCycle[findSlot(cycle, length, hashCycle(cycle, length))] != -1 ? 1 : 0;
+}
+
+void cycleHashSet::getCycle(int k, list <int> &cycle)
+{
+    cycle.assign(storage.begin() + cycleStart[k], storage.begin() + cycleStart[k+1]);
+}
+
+
+sccCycleGenerator::sccCycleGenerator()
+{
+    init();
+}
+
+sccCycleGenerator::~sccCycleGenerator()
+{
+    deleteComponents();
+    delete threadPool;
+}
+
+sccCycleGenerator::sccCycleGenerator(int **someAdjMat,int someNumNodes)
+{
+    init();
+    copyAdjMatInt(someAdjMat,someNumNodes);
+}
+
+sccCycleGenerator::sccCycleGenerator(const csrGraph &someGraph)
+{
+    init();
+    copyGraph(someGraph);
+}
+
+void sccCycleGenerator::init()
+{
+    numNodes = 0;
+    hashBiDirectedCycles = 0;
+    cycleLengthMin = 1;
+    cycleLengthMax = -1;
+    numThreads = 1;
+    threadPool = NULL;
+    curLength = 0;
+    streamPos = 0;
+}
+
+void sccCycleGenerator::deleteComponents()
+{
+    for (int comp=0;comp<compGens.size();comp++)
+    {
+        delete compGens[comp];
+    }
+    compGens.clear();
+    compNodes.clear();
+    nextCompCycle.clear();
+    compDone.clear();
+    cyclesFound.clear();
+    streamComps.clear();
+    streamPos = 0;
+}
+
+void sccCycleGenerator::copyAdjMatInt(int **someAdjMat,int someNumNodes)
+{
+    csrGraph someGraph(someAdjMat,someNumNodes);
+    copyGraph(someGraph);
+}
+
+// Node i of the graph is node localId[i] of its component. Since the nodes of a
+// component are numbered in increasing order, the edges of a component come out
+// sorted and the component graphs have the same cycles, with the same smallest node.
+void sccCycleGenerator::copyGraph(const csrGraph &someGraph)
+{
+    deleteComponents();
+    graph = someGraph;
+    numNodes = graph.getNumNodes();
+
+    int *compId = new int[numNodes];
+    int numComps = tarjanComponents(graph, compId);
+    vector <int> compSize(numComps,0);
+    for (int i=0;i<numNodes;i++)
+    {
+        compSize[compId[i]]++;
+    }
+
+    // Number the non trivial components by their smallest node.
+    vector <int> newComp(numComps,-1);
+    vector <int> localId(numNodes);
+    for (int i=0;i<numNodes;i++)
+    {
+        if (compSize[compId[i]] <= 1)
+        {
+            continue;
+        }
+        if (newComp[compId[i]] == -1)
+        {
+            newComp[compId[i]] = compNodes.size();
+            compNodes.push_back(vector <int> ());
+        }
+        vector <int> &nodes = compNodes[newComp[compId[i]]];
+        localId[i] = nodes.size();
+        nodes.push_back(i);
+    }
+
+    for (int comp=0;comp<compNodes.size();comp++)
+    {
+        vector <pair <int,int> > edges;
+        for (int i=0;i<compNodes[comp].size();i++)
+        {
+            int node = compNodes[comp][i];
+            for (const int *nit=graph.outBegin(node);nit!=graph.outEnd(node);nit++)
+            {
+                if (compId[*nit] == compId[node])
+                {
+                    edges.push_back(pair <int,int> (i,localId[*nit]));
+                }
+            }
+        }
+        csrGraph compGraph(compNodes[comp].size(),edges);
+        cycleGenerator *compGen = new cycleGenerator(compGraph);
+        compGen->setHashBiDirectedCycles(hashBiDirectedCycles);
+        compGen->setCycleLengthMin(cycleLengthMin);
+        compGen->setCycleLengthMax(cycleLengthMax);
+        compGens.push_back(compGen);
+    }
+    nextCompCycle.assign(compGens.size(),list <int> ());
+    compDone.assign(compGens.size(),0);
+
+    delete [] compId;
+}
+
+void sccCycleGenerator::print ()
+{
+    if (numNodes != 0)
+    {
+        graph.print();
+    }
+}
+
+void sccCycleGenerator::clear ()
+{
+    deleteComponents();
+    graph.clear();
+    numNodes = 0;
+}
+
+int sccCycleGenerator::numComponents()
+{
+    return compGens.size();
+}
+
+void sccCycleGenerator::setHashBiDirectedCycles(int x)
+{
+    hashBiDirectedCycles = x;
+    for (int comp=0;comp<compGens.size();comp++)
+    {
+        compGens[comp]->setHashBiDirectedCycles(x);
+    }
+}
+
+void sccCycleGenerator::setCycleLengthMin(int x)
+{
+    cycleLengthMin = x;
+    for (int comp=0;comp<compGens.size();comp++)
+    {
+        compGens[comp]->setCycleLengthMin(x);
+    }
+}
+
+// The component generators stop after their last cycle of size x, so the
+// search does not go on to the next size just to find it is too big.
+void sccCycleGenerator::setCycleLengthMax(int x)
+{
+    cycleLengthMax = x;
+    for (int comp=0;comp<compGens.size();comp++)
+    {
+        compGens[comp]->setCycleLengthMax(x);
+    }
+}
+
+// As for cycleGenerator, the threads are started here once and kept until the
+// next call, instead of for every runOnComponents.
+void sccCycleGenerator::setNumThreads(int x)
+{
+    if (threadPool != NULL && x == numThreads)
+    {
+        return;
+    }
+    numThreads = x;
+    delete threadPool;
+    threadPool = numThreads > 1 ? new graphThreadPool(numThreads) : NULL;
+}
+
+void sccCycleGenerator::runOnComponents(const vector <int> &comps, const function <void (int)> &work)
+{
+    if (threadPool == NULL || comps.size() <= 1)
+    {
+        for (int k=0;k<comps.size();k++)
+        {
+            work(comps[k]);
+        }
+        return;
+    }
+    for (int k=0;k<comps.size();k++)
+    {
+        threadPool->addTask(bind(work,comps[k]));
+    }
+    threadPool->wait();
+}
+
+// First every component that is not done gets its next cycle (if it has none
+// waiting). The smallest size among them is the next size. Then with threads
+// each component with a cycle of that size collects all its cycles of that size.
+// Each component is only touched by one thread at a time.
+int sccCycleGenerator::collectNextLength()
+{
+    vector <int> needCycle;
+    for (int comp=0;comp<compGens.size();comp++)
+    {
+        if (compDone[comp] == 0 && nextCompCycle[comp].size() == 0)
+        {
+            needCycle.push_back(comp);
+        }
+    }
+    runOnComponents(needCycle,[&](int comp)
+    {
+        nextCompCycle[comp] = compGens[comp]->nextCycle();
+        if (nextCompCycle[comp].size() == 0)
+        {
+            compDone[comp] = 1;
+        }
+    });
+
+    curLength = -1;
+    for (int comp=0;comp<compGens.size();comp++)
+    {
+        if (compDone[comp] == 0 && (curLength == -1 || nextCompCycle[comp].size() < curLength))
+        {
+            curLength = nextCompCycle[comp].size();
+        }
+    }
+    if (curLength == -1)
+    {
+        return 0;
+    }
+
+    vector <int> atLength;
+    for (int comp=0;comp<compGens.size();comp++)
+    {
+        if (compDone[comp] == 0 && nextCompCycle[comp].size() == curLength)
+        {
+            atLength.push_back(comp);
+        }
+    }
+    if (numThreads <= 1)
+    {
+        streamComps = atLength;
+        streamPos = 0;
+        return 1;
+    }
+
+    vector < list < list <int> > > compCycles(compGens.size());
+    runOnComponents(atLength,[&](int comp)
+    {
+        while (nextCompCycle[comp].size() == curLength)
+        {
+            compCycles[comp].push_back(list <int> ());
+            list <int>::iterator lit;
+            for (lit=nextCompCycle[comp].begin();lit!=nextCompCycle[comp].end();lit++)
+            {
+                compCycles[comp].back().push_back(compNodes[comp][*lit]);
+            }
+            nextCompCycle[comp] = compGens[comp]->nextCycle();
+        }
+        if (nextCompCycle[comp].size() == 0)
+        {
+            compDone[comp] = 1;
+        }
+    });
+
+    for (int k=0;k<atLength.size();k++)
+    {
+        cyclesFound.splice(cyclesFound.end(),compCycles[atLength[k]]);
+    }
+    return 1;
+}
+
+list <int> sccCycleGenerator::nextCycle()
+{
+    list <int> retList;
+    while (1)
+    {
+        if (cyclesFound.size() != 0)
+        {
+            retList.swap(cyclesFound.front());
+            cyclesFound.pop_front();
+            return retList;
+        }
+        for (;streamPos<streamComps.size();streamPos++)
+        {
+            int comp = streamComps[streamPos];
+            if (nextCompCycle[comp].size() == curLength)
+            {
+                list <int>::iterator lit;
+                for (lit=nextCompCycle[comp].begin();lit!=nextCompCycle[comp].end();lit++)
+                {
+                    retList.push_back(compNodes[comp][*lit]);
+                }
+                nextCompCycle[comp] = compGens[comp]->nextCycle();
+                if (nextCompCycle[comp].size() == 0)
+                {
+                    compDone[comp] = 1;
+                }
+                return retList;
+            }
+        }
+        if (collectNextLength() == 0)
+        {
+            return retList;
+        }
+    }
+}
+
+johnsonCycleGenerator::johnsonCycleGenerator()
+{
+    init();
+}
+
+johnsonCycleGenerator::~johnsonCycleGenerator()
+{
+}
+
+johnsonCycleGenerator::johnsonCycleGenerator(int **someAdjMat,int someNumNodes)
+{
+    init();
+    copyAdjMatInt(someAdjMat,someNumNodes);
+}
+
+johnsonCycleGenerator::johnsonCycleGenerator(const csrGraph &someGraph)
+{
+    init();
+    copyGraph(someGraph);
+}
+
+void johnsonCycleGenerator::init()
+{
+    numNodes = 0;
+    hashBiDirectedCycles = 0;
+    cycleLengthMin = 1;
+    cycleLengthMax = -1;
+    startNode = -1;
+}
+
+void johnsonCycleGenerator::copyAdjMatInt(int **someAdjMat,int someNumNodes)
+{
+    graph.fromAdjMat(someAdjMat, someNumNodes, 1);
+    numNodes = someNumNodes;
+    restart();
+}
+
+void johnsonCycleGenerator::copyGraph(const csrGraph &someGraph)
+{
+    graph = someGraph;
+    graph.buildReverse();
+    numNodes = graph.getNumNodes();
+    restart();
+}
+
+void johnsonCycleGenerator::restart()
+{
+    startNode = -1;
+    forwardMark.assign(numNodes,-1);
+    forwardDist.assign(numNodes,0);
+    backwardMark.assign(numNodes,-1);
+    backDist.assign(numNodes,0);
+    inComp.assign(numNodes,-1);
+    blocked.assign(numNodes,0);
+    blockedBy.assign(numNodes,vector <int> ());
+    path.clear();
+    nextNeighbor.clear();
+    foundCycle.clear();
+
+    compId.assign(numNodes,0);
+    compSize.clear();
+    if (numNodes != 0)
+    {
+        compSize.assign(tarjanComponents(graph,compId.data()),0);
+        for (int i=0;i<numNodes;i++)
+        {
+            compSize[compId[i]]++;
+        }
+    }
+}
+
+void johnsonCycleGenerator::print ()
+{
+    if (numNodes != 0)
+    {
+        graph.print();
+    }
+}
+
+void johnsonCycleGenerator::clear ()
+{
+    graph.clear();
+    numNodes = 0;
+    restart();
+}
+
+void johnsonCycleGenerator::setHashBiDirectedCycles(int x)
+{
+    hashBiDirectedCycles = x;
+}
+
+void johnsonCycleGenerator::setCycleLengthMin(int x)
+{
+    cycleLengthMin = x;
+}
+
+void johnsonCycleGenerator::setCycleLengthMax(int x)
+{
+    cycleLengthMax = x;
+}
+
+// The component of startNode among the nodes >= startNode is the set of nodes
+// reached both by a forward and a backward search from it. It lies inside the
+// component of startNode in the whole graph, so the searches stay in there.
+// With cycleLengthMax set only the nodes on a short enough cycle through startNode
+// are needed: those less than cycleLengthMax steps from it both ways, with the two
+// distances adding up to at most cycleLengthMax. The searches are breadth first so
+// they can stop at that depth, and backDist keeps the distances back to startNode.
+int johnsonCycleGenerator::nextStartNode()
 {
-    //cout << "[pathInSpanningTreeDFS] curNode: " << curNode << " path: ";
-    //printListInt(path);
-    if (curNode == endNode)
+    vector <int> searchQueue;
+    while (startNode < numNodes - 1)
     {
-        return 1;
-    }
+        startNode++;
+        int s = startNode;
+        int sComp = compId[s];
+        if (compSize[sComp] == 1)
+        {
+            continue;
+        }
+        int maxDepth = cycleLengthMax == -1 ? numNodes : cycleLengthMax - 1;
 
-    for (int i=0;i<numNodes;i++)
-    {
-        if (adjMat[curNode][i] == 1 && i != curNode)
+        forwardMark[s] = s;
+        forwardDist[s] = 0;
+        searchQueue.assign(1,s);
+        for (int head=0;head<searchQueue.size();head++)
         {
-            //recurse
-            if (pathInSpanningTreeDFS(adjMat, numNodes, i, endNode,path) == 1)
+            int v = searchQueue[head];
+            if (forwardDist[v] >= maxDepth)
             {
-                //cout << " curNode: " << curNode << " i:" << i << "  found endNode. " << endl;
-                // Then i is in the path
-                path.push_front(i);
-                return 1;
+                continue;
+            }
+            for (const int *nit=graph.outBegin(v);nit!=graph.outEnd(v);nit++)
+            {
+                if (*nit > s && compId[*nit] == sComp && forwardMark[*nit] != s)
+                {
+                    forwardMark[*nit] = s;
+                    forwardDist[*nit] = forwardDist[v] + 1;
+                    searchQueue.push_back(*nit);
+                }
+            }
+        }
+
+        int numInComp = 1;
+        inComp[s] = s;
+        backwardMark[s] = s;
+        backDist[s] = 0;
+        searchQueue.assign(1,s);
+        for (int head=0;head<searchQueue.size();head++)
+        {
+            int v = searchQueue[head];
+            blocked[v] = 0;
+            blockedBy[v].clear();
+            if (backDist[v] >= maxDepth)
+            {
+                continue;
             }
+            for (const int *nit=graph.inBegin(v);nit!=graph.inEnd(v);nit++)
+            {
+                if (*nit > s && forwardMark[*nit] == s && backwardMark[*nit] != s)
+                {
+                    backwardMark[*nit] = s;
+                    backDist[*nit] = backDist[v] + 1;
+                    searchQueue.push_back(*nit);
+                    if (cycleLengthMax == -1 || forwardDist[*nit] + backDist[*nit] <= cycleLengthMax)
+                    {
+                        inComp[*nit] = s;
+                        numInComp++;
+                    }
+                }
+            }
+        }
+
+        if (numInComp > 1)
+        {
+            path.push_back(s);
+            nextNeighbor.push_back(graph.outBegin(s));
+            foundCycle.push_back(0);
+            blocked[s] = 1;
+            return 1;
         }
     }
     return 0;
 }
 
-
-// This reads through the adjacency matrix and looks for -1.
-// If a -1 is found the edge i -> j is recorded.
-list <vector <int> > getBackEdges(int **adjMat, int numNodes)
+void johnsonCycleGenerator::unblock(int u)
 {
-    list <vector <int> > retList;
-    for (int i=0;i<numNodes;i++)
+    vector <int> unblockStack;
+    blocked[u] = 0;
+    unblockStack.push_back(u);
+    while (unblockStack.size() != 0)
     {
-        for (int j=0;j<numNodes;j++)
+        int v = unblockStack.back();
+        unblockStack.pop_back();
+        for (int k=0;k<blockedBy[v].size();k++)
         {
-            if (adjMat[i][j] == -1)
+            int w = blockedBy[v][k];
+            if (blocked[w] == 1)
             {
-                vector <int> backEdge;
-                backEdge.clear();
-                backEdge.insert(backEdge.begin(),j);
-                backEdge.insert(backEdge.begin(),i);
-                retList.push_back(backEdge);
+                blocked[w] = 0;
+                unblockStack.push_back(w);
             }
         }
+        blockedBy[v].clear();
     }
-    return retList;
 }
 
-list <list <int> > getMinCycles(int **adjMat,int numNodes)
+// This is Johnson's CIRCUIT procedure with the recursion replaced by path,
+// nextNeighbor and foundCycle, so it can stop at each cycle and carry on later.
+int johnsonCycleGenerator::findCycle()
 {
-    int **tempAdjMat =allocateAdjMat(numNodes);
-    int **spanTreeBackEdges = allocateAdjMat(numNodes);
-    int **spanTree = allocateAdjMat(numNodes);
-    list <list <int> > minCycles;
-
-    //printMat(adjMat,numNodes);
-
-    list <set <int> > strongConComps = tarjan(adjMat, numNodes);
-
-    //cout << "Strongly connected components." << endl;
-    //cout << "strongConComps.size() = " << strongConComps.size() << endl;
-
-    list <set <int> >::iterator lsit;
-
-    for (lsit= strongConComps.begin();lsit!=strongConComps.end();lsit++)
+    while (1)
     {
-        ////cout << "(*lsit).size() = " << (*lsit).size() << endl;
-        set <int>::iterator sit;
-        for (sit = (*lsit).begin();sit!=(*lsit).end();sit++)
+        if (path.size() == 0 && nextStartNode() == 0)
+        {
+            return 0;
+        }
+
+        int depth = path.size() - 1;
+        int v = path[depth];
+        if (nextNeighbor[depth] != graph.outEnd(v))
         {
-            //cout << *sit << " ";
+            int w = *(nextNeighbor[depth]);
+            nextNeighbor[depth]++;
+            if (w == v || inComp[w] != startNode)
+            {
+                continue;
+            }
+            if (w == startNode)
+            {
+                foundCycle[depth] = 1;
+                int cycleLength = path.size();
+                if (cycleLength < cycleLengthMin)
+                {
+                    continue;
+                }
+                if (hashBiDirectedCycles == 1 && cycleLength > 2 && path[1] > path[cycleLength-1])
+                {
+                    // Skip it if the other orientation is also a cycle, that one is returned instead.
+                    int biDirected = 1;
+                    for (int k=0;k<cycleLength && biDirected == 1;k++)
+                    {
+                        biDirected = graph.hasEdge(path[(k+1) % cycleLength],path[k]);
+                    }
+                    if (biDirected == 1)
+                    {
+                        continue;
+                    }
+                }
+                return 1;
+            }
+            if (blocked[w] == 0)
+            {
+                if (cycleLengthMax != -1 && path.size() + backDist[w] > cycleLengthMax)
+                {
+                    // Going on could only give cycles that are too long. Count it as a
+                    // cycle found, so v is unblocked and nothing is wrongly pruned later.
+                    foundCycle[depth] = 1;
+                    continue;
+                }
+                path.push_back(w);
+                nextNeighbor.push_back(graph.outBegin(w));
+                foundCycle.push_back(0);
+                blocked[w] = 1;
+            }
+            continue;
         }
-        //cout << endl;
-    }
 
-    //cout << "Calculating spanning tree (with back edges) of each strongly connected component." << endl;
-    for (lsit= strongConComps.begin();lsit!=strongConComps.end();lsit++)
-    {
-        ////cout << "(*lsit).size() = " << (*lsit).size() << endl;
-        set <int>::iterator sit;
-        for (sit = (*lsit).begin();sit!=(*lsit).end();sit++)
+        // All neighbors of v are done.
+        if (foundCycle[depth] == 1)
         {
-            //cout << *sit << " ";
+            unblock(v);
         }
-        //cout << endl;
-        if ((*lsit).size() > 1)
+        else
         {
-
-            getSubAdjMat (adjMat, tempAdjMat, numNodes, (*lsit));
-            //printMat (tempAdjMat, numNodes);
-
-            spanTreeWithBackEdges (tempAdjMat, spanTreeBackEdges, numNodes);
-            //cout << "Spanning tree with back edges." << endl;
-            //printMat (spanTreeBackEdges,numNodes);
-            //cout << "Spanning tree." << endl;
-            stripNeg(spanTreeBackEdges,spanTree, numNodes);
-            //printMat (spanTree,numNodes);
-            //cout << "Minimum cycles:" << endl;
-
-            list <vector <int> > backEdges = getBackEdges(spanTreeBackEdges, numNodes);
-            list <vector <int> >::iterator llit;
-            for (llit=backEdges.begin();llit!=backEdges.end();llit++)
+            for (const int *nit=graph.outBegin(v);nit!=graph.outEnd(v);nit++)
             {
-                //cout << "Back edge: " << (*llit)[0] << " " << (*llit)[1] << endl;
-
-                list <int> path = pathInSpanningTree(spanTree, numNodes, (*llit)[1], (*llit)[0] );
-                //cout << "Path: " ;
-                //printListInt(path);
-                minCycles.push_back(path);
+                int w = *nit;
+                if (w != v && inComp[w] == startNode && find(blockedBy[w].begin(),blockedBy[w].end(),v) == blockedBy[w].end())
+                {
+                    blockedBy[w].push_back(v);
+                }
             }
-            
-
-            //cout << endl;
         }
-        else
+        int found = foundCycle[depth];
+        path.pop_back();
+        nextNeighbor.pop_back();
+        foundCycle.pop_back();
+        if (depth > 0 && found == 1)
         {
-            //cout << "Only one element. Skipping. " << endl;
+            foundCycle[depth-1] = 1;
         }
+    }
+}
 
+list <int> johnsonCycleGenerator::nextCycle()
+{
+    list <int> retList;
+    if (numNodes != 0 && findCycle() == 1)
+    {
+        retList.assign(path.begin(),path.end());
     }
+    return retList;
+}
 
-    deleteAdjMat(tempAdjMat,numNodes);
-    deleteAdjMat(spanTreeBackEdges,numNodes);
-    deleteAdjMat(spanTree,numNodes);
+// The labels start this far apart, so a component can be split many times
+// before the labels have to be spread out again.
+const long long DYNAMIC_SCC_LABEL_GAP = 1LL << 32;
 
-    return minCycles;
+dynamicSCC::dynamicSCC()
+{
+    clear();
 }
 
+dynamicSCC::dynamicSCC(int **someAdjMat, int someNumNodes)
+{
+    copyAdjMatInt(someAdjMat,someNumNodes);
+}
 
-// Allocates a new matrix and fills it with a copy of the one given.
-int **copyAdjMat(int **adjMat, int numNodes)
+dynamicSCC::dynamicSCC(const csrGraph &someGraph)
 {
-    int **retMat = allocateAdjMat(numNodes);
+    copyGraph(someGraph);
+}
+
+void dynamicSCC::clear()
+{
+    numNodes = 0;
+    numComps = 0;
+    outEdges.clear();
+    inEdges.clear();
+    compOf.clear();
+    compNodes.clear();
+    compLabel.clear();
+    freeComps.clear();
+    labelOrder.clear();
+    forwardMark.clear();
+    backwardMark.clear();
+    nodeForwardMark.clear();
+    nodeBackwardMark.clear();
+    curStamp = 0;
+}
+
+void dynamicSCC::copyAdjMatInt(int **someAdjMat, int someNumNodes)
+{
+    csrGraph someGraph(someAdjMat,someNumNodes);
+    copyGraph(someGraph);
+}
+
+// tarjanComponents numbers the components in reverse topological order, so
+// component c gets the label of position numComps-1-c.
+void dynamicSCC::copyGraph(const csrGraph &someGraph)
+{
+    clear();
+    numNodes = someGraph.getNumNodes();
+    outEdges.resize(numNodes);
+    inEdges.resize(numNodes);
     for (int i=0;i<numNodes;i++)
     {
-        for (int j=0;j<numNodes;j++)
+        for (const int *nit=someGraph.outBegin(i);nit!=someGraph.outEnd(i);nit++)
         {
-            retMat[i][j] = adjMat[i][j];
+            outEdges[i].push_back(*nit);
+            inEdges[*nit].push_back(i);
         }
     }
-    return retMat;
-}
 
+    compOf.resize(numNodes);
+    numComps = tarjanComponents(someGraph,compOf.data());
+    compNodes.resize(numComps);
+    compLabel.resize(numComps);
+    forwardMark.assign(numComps,0);
+    backwardMark.assign(numComps,0);
+    nodeForwardMark.assign(numNodes,0);
+    nodeBackwardMark.assign(numNodes,0);
+    for (int i=0;i<numNodes;i++)
+    {
+        compNodes[compOf[i]].push_back(i);
+    }
+    for (int c=0;c<numComps;c++)
+    {
+        setLabel(c,(numComps-1-c)*DYNAMIC_SCC_LABEL_GAP);
+    }
+}
 
-// Use the orientation rules from "Causal inference and causal explanation with background knowledge"
-// Meek 1995. Also in "Characteristic imsets for learning Bayesian network structures", Hemmecke et. al.
-// Given a CIM solution which may not be from a DAG, I think it is not correct to use the 
-// "orientation rules". That is, the orientation rules assume the graph which generated the CIM was a DAG!
-int **essGraphFromPatGraph(int **patMat, int numNodes)
+int dynamicSCC::hasEdge(int a, int b)
 {
-    int **essMat = copyAdjMat(patMat, numNodes);
+    return find(outEdges[a].begin(),outEdges[a].end(),b) != outEdges[a].end() ? 1 : 0;
+}
 
-    int ruleApplied = 1;
-    while (ruleApplied == 1)
+int dynamicSCC::addEdge(int a, int b)
+{
+    if (hasEdge(a,b) == 1)
     {
-        ruleApplied = 0;
+        return 0;
+    }
+    outEdges[a].push_back(b);
+    inEdges[b].push_back(a);
 
-        //
+    if (compOf[a] != compOf[b] && compLabel[compOf[a]] > compLabel[compOf[b]])
+    {
+        reorder(compOf[a],compOf[b]);
     }
+    return 1;
 }
 
-// Reverses the list myList
-list <int> revList(list <int> myList)
+int dynamicSCC::removeEdge(int a, int b)
 {
-    list <int> retList;
-    if (myList.size() <= 1)
+    vector <int>::iterator vit = find(outEdges[a].begin(),outEdges[a].end(),b);
+    if (vit == outEdges[a].end())
     {
-        return myList;
+        return 0;
     }
+    *vit = outEdges[a].back();
+    outEdges[a].pop_back();
+    vit = find(inEdges[b].begin(),inEdges[b].end(),a);
+    *vit = inEdges[b].back();
+    inEdges[b].pop_back();
 
-    list <int>::iterator lit = myList.end();
-    lit--;
-    for (;lit!=myList.begin();lit--)
+    // Removing an edge between components keeps the order valid. Inside a
+    // component nothing changes as long as a can still reach b.
+    if (a != b && compOf[a] == compOf[b] && stillReaches(a,b) == 0)
     {
-        retList.push_back(*lit);
+        splitComponent(compOf[a]);
     }
-    retList.push_back(*lit);
-    return retList;
+    return 1;
 }
 
-// This assumes myList is a cycle and returns the
-// representation with the minimum node number as the start.
-list <int> uniqueCycle(list <int> myList)
+// The new edge goes from tailComp back to headComp, which has a lower label.
+// forward is everything reachable from headComp with labels up to tailComp's and
+// backward everything reaching tailComp with labels down to headComp's. If
+// tailComp is in forward there is a new cycle and the components in both sets are
+// merged. Then the labels of the two sets are handed out again in sorted order:
+// first backward, then the merged component, then forward.
+void dynamicSCC::reorder(int tailComp, int headComp)
 {
-    list <int> retList;
-    if (myList.size() <= 1)
+    long long lowLabel = compLabel[headComp];
+    long long highLabel = compLabel[tailComp];
+    curStamp++;
+
+    vector <int> forward;
+    vector <int> stack(1,headComp);
+    forwardMark[headComp] = curStamp;
+    while (!stack.empty())
     {
-        return myList;
+        int comp = stack.back();
+        stack.pop_back();
+        forward.push_back(comp);
+        for (int i=0;i<compNodes[comp].size();i++)
+        {
+            int v = compNodes[comp][i];
+            for (int k=0;k<outEdges[v].size();k++)
+            {
+                int next = compOf[outEdges[v][k]];
+                if (forwardMark[next] != curStamp && compLabel[next] <= highLabel)
+                {
+                    forwardMark[next] = curStamp;
+                    stack.push_back(next);
+                }
+            }
+        }
     }
 
-    list <int>::iterator minVal;
-    list <int>::iterator lit=myList.begin();
-    int curMin = *lit;
-    minVal = lit;
-    // Find the min value;
-    for (;lit!=myList.end();lit++)
+    vector <int> backward;
+    stack.push_back(tailComp);
+    backwardMark[tailComp] = curStamp;
+    while (!stack.empty())
     {
-        if (*lit < curMin )
+        int comp = stack.back();
+        stack.pop_back();
+        backward.push_back(comp);
+        for (int i=0;i<compNodes[comp].size();i++)
         {
-            minVal = lit;
-            curMin = *lit;
+            int v = compNodes[comp][i];
+            for (int k=0;k<inEdges[v].size();k++)
+            {
+                int next = compOf[inEdges[v][k]];
+                if (backwardMark[next] != curStamp && compLabel[next] >= lowLabel)
+                {
+                    backwardMark[next] = curStamp;
+                    stack.push_back(next);
+                }
+            }
         }
     }
 
-    lit = minVal;
-    for (int i=0;i<myList.size();i++)
+    vector <long long> labels;
+    for (int k=0;k<forward.size();k++)
     {
-        if (lit == myList.end())
+        labels.push_back(compLabel[forward[k]]);
+    }
+    for (int k=0;k<backward.size();k++)
+    {
+        if (forwardMark[backward[k]] != curStamp)
         {
-            lit = myList.begin();
+            labels.push_back(compLabel[backward[k]]);
         }
-        retList.push_back(*lit);
-        lit++;
     }
-    return retList;
-}
+    sort(labels.begin(),labels.end());
 
-// Returns 1 if the graphs are the same
-int graphSame(int **adjMatOne, int **adjMatTwo, int numNodes)
-{
-    int same = 1;
-    for (int i=0;i<numNodes;i++)
+    // Sort both sets by label and pull out the components on the new cycle.
+    vector <pair <long long,int> > forwardOnly, backwardOnly;
+    vector <int> cycleComps;
+    for (int k=0;k<forward.size();k++)
     {
-        for (int j=0;j<numNodes;j++)
+        if (backwardMark[forward[k]] == curStamp)
         {
-            if (adjMatOne[i][j] != adjMatTwo[i][j])
-            {
-                same = 0;
-                i = numNodes;
-                j = numNodes;
-            }
+            cycleComps.push_back(forward[k]);
+        }
+        else
+        {
+            forwardOnly.push_back(pair <long long,int> (compLabel[forward[k]],forward[k]));
         }
     }
-    return same;
-}
-
-cycleGenerator::cycleGenerator()
-{
-    init();
-}
-
-cycleGenerator::~cycleGenerator()
-{
-    if (numNodes != 0)
+    for (int k=0;k<backward.size();k++)
     {
-        deleteAdjMat(adjMat,numNodes);
+        if (forwardMark[backward[k]] != curStamp)
+        {
+            backwardOnly.push_back(pair <long long,int> (compLabel[backward[k]],backward[k]));
+        }
     }
-}
-
-cycleGenerator::cycleGenerator(int **someAdjMat,int someNumNodes)
-{
-    init();
-    copyAdjMatInt(someAdjMat,someNumNodes);
-}
+    sort(forwardOnly.begin(),forwardOnly.end());
+    sort(backwardOnly.begin(),backwardOnly.end());
 
-void cycleGenerator::copyAdjMatInt(int **someAdjMat,int someNumNodes)
-{
-    if (numNodes != 0)
+    for (int k=0;k<labels.size();k++)
     {
-        // Delete previous adjMat
-        deleteAdjMat(adjMat,numNodes);
-        numNodes = 0;
+        labelOrder.erase(labels[k]);
     }
 
-    adjMat = copyAdjMat(someAdjMat, someNumNodes);
-    numNodes = someNumNodes;
-
-    addVertToPathQueue();
-}
-
-void cycleGenerator::init()
-{
-    hashBiDirectedCycles=0;
-    adjMat = NULL;
-    numNodes = 0;
-    oneStepCalls=0;
-    cycleLengthMin=1;
-}
-
-
-void cycleGenerator::print () // Prints the adj matrix,
-{
-    if (numNodes != 0)
+    // As in Pearce-Kelly the backward components take the lowest labels and the
+    // forward ones the highest, so a backward label only goes down and a forward
+    // label only goes up, and edges from outside the searched region stay in order.
+    // A merge leaves some labels in the middle unused. They are simply gaps.
+    int numBackward = backwardOnly.size();
+    for (int k=0;k<numBackward;k++)
     {
-        printMat(adjMat,numNodes);
+        setLabel(backwardOnly[k].second,labels[k]);
     }
-}
-
-void cycleGenerator::clear ()
-{
-    if (numNodes != 0)
+    if (cycleComps.size() != 0)
     {
-        // Delete previous adjMat
-        deleteAdjMat(adjMat,numNodes);
-        numNodes = 0;
+        // Merge into the largest component, so the fewest nodes move.
+        int target = cycleComps[0];
+        for (int k=1;k<cycleComps.size();k++)
+        {
+            if (compNodes[cycleComps[k]].size() > compNodes[target].size())
+            {
+                target = cycleComps[k];
+            }
+        }
+        for (int k=0;k<cycleComps.size();k++)
+        {
+            int comp = cycleComps[k];
+            if (comp == target)
+            {
+                continue;
+            }
+            for (int i=0;i<compNodes[comp].size();i++)
+            {
+                compOf[compNodes[comp][i]] = target;
+                compNodes[target].push_back(compNodes[comp][i]);
+            }
+            compNodes[comp].clear();
+            freeComps.push_back(comp);
+            numComps--;
+        }
+        setLabel(target,labels[numBackward]);
     }
-    pathQueue.clear();
-    cyclesFound.clear();
-    uniqBiDirectedCycles.clear();
-    oneStepCalls=0;
-}
-
-void cycleGenerator::addVertToPathQueue()
-{
-    list <int> newList;
-    for (int i=0;i<numNodes;i++)
+    int firstForward = labels.size() - forwardOnly.size();
+    for (int k=0;k<forwardOnly.size();k++)
     {
-        newList.clear();
-        newList.push_back(i);
-        pathQueue.push_back(newList);
+        setLabel(forwardOnly[k].second,labels[firstForward+k]);
     }
 }
 
-int cycleGenerator::oneStep ()
+// Searches forward from a and backward from b at the same time, always growing
+// the smaller side, inside the component of a. In a well connected component the
+// two searches meet after a few steps, so this is much cheaper than Tarjan.
+int dynamicSCC::stillReaches(int a, int b)
 {
-    //cout << "[cycleGenerator::oneStep] pathQueue.size() = " << pathQueue.size();
-    //cout << " cyclesFound.size() = " << cyclesFound.size() << endl;
-    oneStepCalls++;
-    list <int> curPath;
-
-    if (pathQueue.size() != 0)
+    int comp = compOf[a];
+    curStamp++;
+    vector <int> forwardQueue(1,a);
+    vector <int> backwardQueue(1,b);
+    int forwardPos = 0;
+    int backwardPos = 0;
+    nodeForwardMark[a] = curStamp;
+    nodeBackwardMark[b] = curStamp;
+    while (forwardPos < forwardQueue.size() && backwardPos < backwardQueue.size())
     {
-        curPath = *(pathQueue.begin());
-        pathQueue.pop_front();
-        int k = curPath.size();
-
-        int head = *(curPath.begin());
-        list <int>::iterator lit;
-
-        lit = curPath.end();
-        lit--;
-        int tail = *lit; // This could equal head
-
-        //cout << "k = " << k << " head = " << head << " tail = " << tail << endl;;
-
-        // Search for cycles using this path.
-        if (k > 1)
+        if (forwardQueue.size() - forwardPos <= backwardQueue.size() - backwardPos)
         {
-            if (adjMat[tail][head] == 1)
+            int v = forwardQueue[forwardPos++];
+            for (int k=0;k<outEdges[v].size();k++)
             {
-                //cout << "    Found Cycle." << endl;
-                // There exists a path. Add it to the cycle queue
-                if (hashBiDirectedCycles == 1 && isCycleBiDirected(curPath) == 1 && curPath.size() > 2)
+                int next = outEdges[v][k];
+                if (compOf[next] != comp || nodeForwardMark[next] == curStamp)
                 {
-                    // If we are hashing bidirected cycles, add it to hash
-                    list <int> uniqCycle = uniqueBiDirCycle(curPath);
-                    //cout << "curPath: ";
-                    //printListInt(curPath);
-                    //cout << "uniqCycle: ";
-                    //printListInt(uniqCycle);
-                    //cout << "uniqBiDirectedCycles.size() = " << uniqBiDirectedCycles.size() << endl;
-                    //printUniqBiDirectedCycles();
-                    if(uniqBiDirectedCycles.find(uniqCycle) == uniqBiDirectedCycles.end())
-                    {
-                        //cout << "here" << endl;
-                        // Add it to the hash and the cyclesFound
-                        if (cycleLengthMin <= curPath.size())
-                        {
-                            cyclesFound.push_back(curPath);
-                        }
-                        uniqBiDirectedCycles.insert(uniqCycle);
-                    }
-                    // else a representative of this cycle is already in our list.
+                    continue;
                 }
-                else {
-                    if (cycleLengthMin <= curPath.size())
-                    {
-                        cyclesFound.push_back(curPath);
-                    }
+                if (nodeBackwardMark[next] == curStamp)
+                {
+                    return 1;
                 }
+                nodeForwardMark[next] = curStamp;
+                forwardQueue.push_back(next);
             }
         }
-
-        // Now try to add all possible paths of length k using curPath
-        // where the new vertex is larger than the tail
-        for (int i=head+1;i< numNodes;i++)
+        else
         {
-            //cout << "    adjMat[" << tail << "][" << i << "] = " << adjMat[tail][i] << endl;
-            if (adjMat[tail][i] == 1 && i != head && isInList(i,curPath) == 0)
+            int v = backwardQueue[backwardPos++];
+            for (int k=0;k<inEdges[v].size();k++)
             {
-                //cout << "        Add it" << endl;
-                list <int> newPath = curPath;
-                newPath.push_back(i);
-                pathQueue.push_back(newPath);
+                int next = inEdges[v][k];
+                if (compOf[next] != comp || nodeBackwardMark[next] == curStamp)
+                {
+                    continue;
+                }
+                if (nodeForwardMark[next] == curStamp)
+                {
+                    return 1;
+                }
+                nodeBackwardMark[next] = curStamp;
+                backwardQueue.push_back(next);
             }
         }
-        return 1;
     }
-    
     return 0;
 }
 
-list <int> cycleGenerator::nextCycle()
+void dynamicSCC::splitComponent(int comp)
 {
-    list <int> retList;
-    if (numNodes == 0 || pathQueue.size() == 0)
+    // Relabel the component 0 .. size-1 and find its components.
+    vector <int> nodes;
+    nodes.swap(compNodes[comp]);
+    int size = nodes.size();
+    for (int i=0;i<size;i++)
     {
-        // either no adj matrix, or we have exhausted all the cycles.
-        return retList;
+        compOf[nodes[i]] = -1 - i; // Temporarily, so the edges in comp can be told apart.
+    }
+    vector <pair <int,int> > edges;
+    for (int i=0;i<size;i++)
+    {
+        int v = nodes[i];
+        for (int k=0;k<outEdges[v].size();k++)
+        {
+            if (compOf[outEdges[v][k]] < 0)
+            {
+                edges.push_back(pair <int,int> (i,-1-compOf[outEdges[v][k]]));
+            }
+        }
+    }
+    csrGraph localGraph(size,edges);
+    vector <int> localComp(size);
+    int numPieces = tarjanComponents(localGraph,localComp.data());
+    for (int i=0;i<size;i++)
+    {
+        compOf[nodes[i]] = comp;
+    }
+    if (numPieces == 1)
+    {
+        nodes.swap(compNodes[comp]);
+        return;
     }
-    if (cyclesFound.size() == 0 && numNodes != 0)
+
+    // The pieces go in the gap between the labels next to comp.
+    long long lowLabel, highLabel;
+    while (1)
     {
-        while (cyclesFound.size() == 0 && oneStep() == 1)
+        map <long long,int>::iterator mit = labelOrder.find(compLabel[comp]);
+        lowLabel = mit->first - (numPieces+1)*DYNAMIC_SCC_LABEL_GAP;
+        highLabel = mit->first + (numPieces+1)*DYNAMIC_SCC_LABEL_GAP;
+        if (mit != labelOrder.begin())
         {
+            map <long long,int>::iterator prev = mit;
+            prev--;
+            lowLabel = prev->first;
         }
-        if (cyclesFound.size() == 0 && pathQueue.size() == 0)
+        mit++;
+        if (mit != labelOrder.end())
         {
-            // We have exhausted all the cycles.
-            return retList;
+            highLabel = mit->first;
         }
-        retList = *(cyclesFound.begin());
-        cyclesFound.pop_front();
-           
-        return retList;
+        if (highLabel - lowLabel > numPieces)
+        {
+            break;
+        }
+        relabelAll();
+    }
+    long long label = compLabel[comp];
+    long long step = (highLabel - lowLabel)/(numPieces + 1);
 
+    // Tarjan finds the pieces in reverse topological order, so piece p gets
+    // the (numPieces-1-p)-th label.
+    vector <int> pieceComp(numPieces);
+    pieceComp[0] = comp;
+    for (int p=1;p<numPieces;p++)
+    {
+        pieceComp[p] = newComponent();
+    }
+    for (int i=0;i<size;i++)
+    {
+        int target = pieceComp[localComp[i]];
+        compOf[nodes[i]] = target;
+        compNodes[target].push_back(nodes[i]);
+    }
+    labelOrder.erase(label);
+    for (int p=0;p<numPieces;p++)
+    {
+        setLabel(pieceComp[p],lowLabel + step*(numPieces - p));
     }
+    numComps += numPieces - 1;
 }
-int cycleGenerator::numOneStepCall()
+
+int dynamicSCC::newComponent()
 {
-    return oneStepCalls;
+    if (freeComps.size() != 0)
+    {
+        int comp = freeComps.back();
+        freeComps.pop_back();
+        return comp;
+    }
+    compNodes.push_back(vector <int> ());
+    compLabel.push_back(0);
+    forwardMark.push_back(0);
+    backwardMark.push_back(0);
+    return compNodes.size() - 1;
 }
 
-void cycleGenerator::setHashBiDirectedCycles(int x)
+void dynamicSCC::setLabel(int comp, long long label)
 {
-    hashBiDirectedCycles = x;
+    compLabel[comp] = label;
+    labelOrder[label] = comp;
 }
 
-int cycleGenerator::isCycleBiDirected(list <int> myCycle)
+void dynamicSCC::relabelAll()
 {
-    if (myCycle.size() <= 1 || numNodes == 0)
+    map <long long,int> oldOrder;
+    oldOrder.swap(labelOrder);
+    long long label = 0;
+    for (map <long long,int>::iterator mit=oldOrder.begin();mit!=oldOrder.end();mit++)
     {
-        return 0;
+        setLabel(mit->second,label);
+        label += DYNAMIC_SCC_LABEL_GAP;
     }
+}
 
-    list <int>::iterator tempLit;
-    list <int>::iterator lit = myCycle.begin();
-    tempLit = lit;
-    tempLit++;
-    for(;lit!=myCycle.end() && tempLit != myCycle.end();lit++)
-    {
-        //cout << "*lit: " << *lit << " *tempLit: " << *tempLit << endl;
-        if(adjMat[*tempLit][*lit] == 0)
-        {
-            return 0;
-        }
-        tempLit++;
-    }
-    // Now lit is the last node
-    if (adjMat[*(myCycle.begin())][*lit] == 0)
+list <set <int> > dynamicSCC::components()
+{
+    list <set <int> > retList;
+    for (map <long long,int>::reverse_iterator mit=labelOrder.rbegin();mit!=labelOrder.rend();mit++)
     {
-        return 0;
+        retList.push_back(set <int> (compNodes[mit->second].begin(),compNodes[mit->second].end()));
     }
-
-    return 1;
+    return retList;
 }
 
+// Components up to this size are counted by countCyclesSubsets. Its tables take
+// 2^(n-1) (n-1) counts, 4MB at 16 nodes.
+const int COUNT_SUBSET_MAX_NODES = 16;
 
-list <int> cycleGenerator::uniqueBiDirCycle(list <int> myList)
+// For each head h, paths[mask][j] is the number of paths from h that visit exactly
+// the nodes in mask (all above h) and end at the j-th node above h. Every cycle is
+// counted once, from its smallest node.
+void countCyclesSubsets(const csrGraph &g, int maxLength, vector <long long> &counts)
 {
-    //cout << "[cycleGenerator::uniqueBiDirCycle] ";
-    //printListInt(myList);
-
-    if (myList.size() <= 1 || isCycleBiDirected(myList) == 0)
+    int numNodes = g.getNumNodes();
+    vector <uint32_t> outBits(numNodes,0);
+    for (int i=0;i<numNodes;i++)
     {
-        return myList;
+        for (const int *nit=g.outBegin(i);nit!=g.outEnd(i);nit++)
+        {
+            outBits[i] |= ((uint32_t)1) << *nit;
+        }
     }
 
-    list <int> retList;
-
-    list <int>::iterator minVal;
-    list <int>::iterator tempLit;
-    list <int>::iterator lit=myList.begin();
-    int curMin = *lit;
-    minVal = lit;
-    // Find the min value;
-    for (;lit!=myList.end();lit++)
+    vector <long long> paths;
+    for (int h=0;h<numNodes;h++)
     {
-        if (*lit < curMin )
+        int numAbove = numNodes - h - 1;
+        paths.assign(((size_t)1 << numAbove)*numAbove,0);
+        for (int j=0;j<numAbove;j++)
         {
-            minVal = lit;
-            curMin = *lit;
+            if ((outBits[h] >> (h+1+j)) & 1)
+            {
+                paths[((size_t)1 << j)*numAbove + j] = 1;
+            }
+        }
+        for (uint32_t mask=1;mask<((uint32_t)1 << numAbove);mask++)
+        {
+            int length = __builtin_popcount(mask) + 1; // Nodes on the path, with h.
+            if (maxLength != -1 && length > maxLength)
+            {
+                continue;
+            }
+            for (int j=0;j<numAbove;j++)
+            {
+                long long numPaths = paths[(size_t)mask*numAbove + j];
+                if (numPaths == 0)
+                {
+                    continue;
+                }
+                uint32_t tailBits = outBits[h+1+j];
+                if ((tailBits >> h) & 1)
+                {
+                    counts[length] += numPaths;
+                }
+                uint32_t candidates = (tailBits >> (h+1)) & ~mask;
+                while (candidates != 0)
+                {
+                    int next = __builtin_ctz(candidates);
+                    candidates &= candidates - 1;
+                    paths[(size_t)(mask | (((uint32_t)1) << next))*numAbove + next] += numPaths;
+                }
+            }
         }
     }
-    //cout << "Min val: " << *minVal << endl;
+}
 
-    int reverseList = 0;
-    int minPlus,minMinus;
-    lit = minVal;
-    tempLit = minVal;
-    tempLit++;
-    if(lit == myList.begin())
-    {
-        lit++;
-        minPlus = *lit;
-        lit = myList.end();
-        lit--;
-        minMinus = *lit;
-    }
-    else if (tempLit == myList.end())
-    {
-        lit--;
-        minMinus = *lit;
-        lit = myList.begin();
-        minPlus = *lit;
-    }
-    else
-    {
-        lit++;
-        minPlus = *lit;
-        lit--;
-        minMinus = *lit;
-    }
-    //cout << "minPlus: " << minPlus << " minMinus: " << minMinus << endl;
+vector <long long> countCyclesByLength(const csrGraph &g, int maxLength)
+{
+    int numNodes = g.getNumNodes();
+    int maxIndex = maxLength == -1 || maxLength > numNodes ? numNodes : maxLength;
+    vector <long long> counts(maxIndex+1,0);
 
-    if (minPlus > minMinus)
+    vector <int> compId(numNodes);
+    int numComps = tarjanComponents(g,compId.data());
+    vector < vector <int> > compNodes(numComps);
+    vector <int> localId(numNodes);
+    for (int i=0;i<numNodes;i++)
     {
-        return uniqueCycle(revList(myList));
+        localId[i] = compNodes[compId[i]].size();
+        compNodes[compId[i]].push_back(i);
     }
-    else
+
+    for (int comp=0;comp<numComps;comp++)
     {
-        return uniqueCycle(myList);
+        if (compNodes[comp].size() <= 1)
+        {
+            continue;
+        }
+        vector <pair <int,int> > edges;
+        for (int i=0;i<compNodes[comp].size();i++)
+        {
+            int node = compNodes[comp][i];
+            for (const int *nit=g.outBegin(node);nit!=g.outEnd(node);nit++)
+            {
+                if (compId[*nit] == comp && *nit != node)
+                {
+                    edges.push_back(pair <int,int> (i,localId[*nit]));
+                }
+            }
+        }
+        csrGraph compGraph(compNodes[comp].size(),edges);
+        if (compNodes[comp].size() <= COUNT_SUBSET_MAX_NODES)
+        {
+            countCyclesSubsets(compGraph,maxIndex,counts);
+            continue;
+        }
+        johnsonCycleGenerator compGen(compGraph);
+        compGen.setCycleLengthMin(2);
+        compGen.setCycleLengthMax(maxLength);
+        while (compGen.findCycle() == 1)
+        {
+            counts[compGen.currentCycle().size()]++;
+        }
     }
+    return counts;
 }
 
-int cycleGenerator::sizeUniqBiDirectedCycles()
+vector <long long> countCyclesByLength(int **adjMat, int numNodes, int maxLength)
 {
-    return uniqBiDirectedCycles.size();
+    csrGraph g(adjMat,numNodes);
+    return countCyclesByLength(g,maxLength);
 }
 
-void cycleGenerator::printUniqBiDirectedCycles()
+reachabilityIndex::reachabilityIndex()
 {
-    hash_set< list <int> , hashListInt , eqListInt>::iterator hlit;
-
-    for (hlit=uniqBiDirectedCycles.begin();hlit!=uniqBiDirectedCycles.end();hlit++)
-    {
-        list <int> tempList = *hlit;
-        printListInt(tempList);
-    }
+    clear();
+}
 
+reachabilityIndex::reachabilityIndex(int **someAdjMat, int someNumNodes)
+{
+    copyAdjMatInt(someAdjMat,someNumNodes);
 }
 
-void cycleGenerator::setCycleLengthMin(int x)
+reachabilityIndex::reachabilityIndex(const csrGraph &someGraph)
 {
-    cycleLengthMin = x;
+    copyGraph(someGraph);
 }
 
-// Returns true if x is in myList.
-int isInList(int x, list <int> myList)
+void reachabilityIndex::clear()
 {
-    list <int>::iterator lit;
-    for(lit = myList.begin();lit!=myList.end();lit++)
-    {
-        if (x == *lit)
-        {
-            return 1;
-        }
-    }
-    return 0;
+    numNodes = 0;
+    numComps = 0;
+    numWords = 0;
+    compId.clear();
+    reach.clear();
 }
 
+void reachabilityIndex::copyAdjMatInt(int **someAdjMat, int someNumNodes)
+{
+    csrGraph someGraph(someAdjMat,someNumNodes);
+    copyGraph(someGraph);
+}
 
-// Compares the two lists and returns 1 if they are equal.
-int listsEqual (list <int> listOne,list <int> listTwo)
+void reachabilityIndex::copyGraph(const csrGraph &someGraph)
 {
-    if (listOne.size() != listTwo.size())
+    clear();
+    numNodes = someGraph.getNumNodes();
+    compId.resize(numNodes);
+    numComps = tarjanComponents(someGraph,compId.data());
+    numWords = bitWords(numComps);
+    reach.assign((size_t)numComps*numWords,0);
+
+    // The successors of each component, highest first. A higher component is
+    // earlier in the topological order, so its row has more chance to hold the
+    // lower ones and let them be skipped.
+    vector <int> compOffsets(numComps+1,0);
+    vector <int> compOrder(numNodes);
+    for (int i=0;i<numNodes;i++)
     {
-        return 0;
+        compOffsets[compId[i]+1]++;
     }
-    if (listOne.size() == 0 && listTwo.size() == 0)
+    for (int comp=0;comp<numComps;comp++)
     {
-        return 1;
+        compOffsets[comp+1] += compOffsets[comp];
     }
-    list <int>::iterator litOne, litTwo;
-    litOne = listOne.begin();
-    litTwo = listTwo.begin();
-    while (litOne != listOne.end() && litTwo != listTwo.end())
+    vector <int> fill(compOffsets.begin(),compOffsets.end()-1);
+    for (int i=0;i<numNodes;i++)
     {
-        if (*litOne != *litTwo)
+        compOrder[fill[compId[i]]++] = i;
+    }
+
+    vector <int> successors;
+    for (int comp=0;comp<numComps;comp++)
+    {
+        uint64_t *row = reach.data() + (size_t)comp*numWords;
+        setBit(row,comp);
+        successors.clear();
+        for (int k=compOffsets[comp];k<compOffsets[comp+1];k++)
         {
-            return 0;
+            int v = compOrder[k];
+            for (const int *nit=someGraph.outBegin(v);nit!=someGraph.outEnd(v);nit++)
+            {
+                if (compId[*nit] != comp)
+                {
+                    successors.push_back(compId[*nit]);
+                }
+            }
+        }
+        sort(successors.begin(),successors.end());
+        for (int k=successors.size()-1;k>=0;k--)
+        {
+            int next = successors[k];
+            if (testBit(row,next) == 1)
+            {
+                continue;
+            }
+            // Successors are below comp, so only the words up to next's can be set.
+            const uint64_t *nextRow = reach.data() + (size_t)next*numWords;
+            for (int w=0;w<=(next >> 6);w++)
+            {
+                row[w] |= nextRow[w];
+            }
         }
-        litOne++;
-        litTwo++;
     }
-    return 1;
 }
 
-// Returns a string of the list.
-// E.g. [1 3 2 5] would give "1,3,2,5"
-// Up to user to delete the string
-char * listToString(list <int> myList)
+void reachabilityIndex::addEdge(int a, int b)
 {
-    int length = 0;
-    list <int>::iterator lit;
-    list <int>::iterator tempLit;
-    for(lit = myList.begin();lit!=myList.end();lit++)
+    if (reachable(a,b) == 1)
     {
-        // Determine how many digits are in the number.
-        int i=1;
-        while (*lit < (int)pow(10.0,(double)i))
-        {
-            i++;
-        }
-        length += i-1 + 1; //Add extra 1 for the comma
+        return;
     }
-    char *retString = new char[length+1]; //Null terminate
-
-    int curIndex = 0;
-    for(lit = myList.begin();lit!=myList.end();lit++)
+    int tailComp = compId[a];
+    vector <uint64_t> headRow(reach.begin() + (size_t)compId[b]*numWords,reach.begin() + (size_t)(compId[b]+1)*numWords);
+    for (int comp=0;comp<numComps;comp++)
     {
-        tempLit = lit;
-        tempLit++;
-        if (tempLit != myList.end())
+        uint64_t *row = reach.data() + (size_t)comp*numWords;
+        if (testBit(row,tailComp) == 1)
         {
-            sprintf(retString + curIndex,"%d,",*lit); // This will null terminate
-        }
-        else
-        {
-            sprintf(retString + curIndex,"%d",*lit); // This will null terminate
+            for (int w=0;w<numWords;w++)
+            {
+                row[w] |= headRow[w];
+            }
         }
-        curIndex = strlen(retString) - curIndex;;
     }
-
-    return retString;
 }
-
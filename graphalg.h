@@ -33,21 +33,149 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
 #include <iostream>
 #include <iomanip>
 #include <math.h>
+#include <string>
 #include <list>
 #include <vector>
 #include <set>
-#include <ext/hash_set>
-
-using namespace __gnu_cxx;
+#include <map>
+#include <algorithm>
+#include <deque>
+#include <queue>
+#include <functional>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 using namespace std;
 
+// Helpers for sets of nodes packed 64 to a word, e.g. a row of a bit-packed
+// adjacency matrix. Node i is bit (i & 63) of word (i >> 6).
+inline int bitWords(int numBits) { return (numBits + 63) >> 6; }
+inline int testBit(const uint64_t *bits, int i) { return (int)((bits[i >> 6] >> (i & 63)) & 1); }
+inline void setBit(uint64_t *bits, int i) { bits[i >> 6] |= ((uint64_t)1) << (i & 63); }
+inline void clearBit(uint64_t *bits, int i) { bits[i >> 6] &= ~(((uint64_t)1) << (i & 63)); }
+inline int lowestBit(uint64_t word) { return __builtin_ctzll(word); } // word must not be 0
+
+// A fixed number of worker threads running tasks from a shared queue.
+// Tasks may add more tasks. wait() returns once every task added so far,
+// including the ones they added, has finished.
+class graphThreadPool
+{
+    public:
+        graphThreadPool(int someNumThreads); //Constructor
+        ~graphThreadPool(); //Destructor. Waits for the tasks then stops the threads.
+        void addTask(const function <void ()> &task);
+        void wait();
+        int getNumThreads() { return workers.size(); }
+    private:
+        void workerLoop();
+        vector <thread> workers;
+        deque <function <void ()> > tasks;
+        mutex queueLock;
+        condition_variable taskAdded;
+        condition_variable tasksDone;
+        int unfinishedTasks; // Queued plus running.
+        int stopping;
+};
+
+// Compressed sparse row (CSR) representation of a directed graph.
+// The out-neighbors of node v are neighbors[offsets[v]] .. neighbors[offsets[v+1]-1]
+// and are kept sorted, so hasEdge is a binary search. Optionally the reverse
+// graph (the in-neighbors) is stored the same way.
+// As with the adjacency matrices only entries equal to 1 are edges. Self loops
+// are kept; the algorithms skip them exactly like the matrix versions do.
+// For sparse graphs this uses O(n + m) memory instead of O(n^2) and every
+// traversal below runs in O(n + m) instead of scanning all n columns per node.
+class csrGraph
+{
+    public:
+        csrGraph(); //Constructor
+        csrGraph(int **adjMat, int someNumNodes, int withReverse = 0);
+        csrGraph(int someNumNodes, const vector <pair <int,int> > &edges, int withReverse = 0);
+        void fromAdjMat(int **adjMat, int someNumNodes, int withReverse = 0); // Rebuilds the graph from adjMat
+        void fromEdges(int someNumNodes, const vector <pair <int,int> > &edges, int withReverse = 0); // Rebuilds the graph from
+                                                                                                        // a list of edges (tail,head).
+                                                                                                        // Repeated edges are kept once.
+        void fromCSR(int someNumNodes, vector <int> &someOffsets, vector <int> &someNeighbors, int withReverse = 0); // Takes the
+                                                                                                        // arrays as they are stored
+                                                                                                        // here. They are swapped in,
+                                                                                                        // so they are left empty.
+        void buildReverse(); // Builds the in-neighbor arrays if they are not there yet.
+        void clear (); // Empties the graph.
+        int **toAdjMat(); // Returns a new adjacency matrix (see allocateAdjMat). Up to user to delete.
+        void print (); // Prints the graph as an adjacency matrix, same format as printMat.
+
+        int getNumNodes() const { return numNodes; }
+        int getNumEdges() const { return numEdges; }
+        int hasReverse() const { return revOffsets.size() != 0; }
+
+        int outDegree(int v) const { return offsets[v+1] - offsets[v]; }
+        const int *outBegin(int v) const { return neighbors.data() + offsets[v]; }
+        const int *outEnd(int v) const { return neighbors.data() + offsets[v+1]; }
+        // Index of the first out-edge of v. Data kept per edge, in the order of the
+        // neighbors, is at outOffset(v) .. outOffset(v+1)-1.
+        int outOffset(int v) const { return offsets[v]; }
+
+        // Only valid if hasReverse() is true.
+        int inDegree(int v) const { return revOffsets[v+1] - revOffsets[v]; }
+        const int *inBegin(int v) const { return revNeighbors.data() + revOffsets[v]; }
+        const int *inEnd(int v) const { return revNeighbors.data() + revOffsets[v+1]; }
+
+        // Returns 1 if the edge a -> b exists.
+        int hasEdge(int a, int b) const { return binary_search(outBegin(a),outEnd(a),b) ? 1 : 0; }
+    private:
+        int numNodes;
+        int numEdges;
+        vector <int> offsets;      // numNodes + 1 entries
+        vector <int> neighbors;    // numEdges entries
+        vector <int> revOffsets;   // Empty unless the reverse graph was built.
+        vector <int> revNeighbors;
+};
+
+// Graph files. There are three formats:
+//   GRAPH_FILE_MATRIX  The number of nodes then the adjacency matrix, as listdircycles
+//                      has always read it. Only entries equal to 1 are edges.
+//   GRAPH_FILE_EDGES   The header "E numNodes numEdges" then numEdges pairs "tail head".
+//                      Without the header every pair is read and the number of nodes
+//                      is one more than the largest node.
+//   GRAPH_FILE_BINARY  The 8 bytes "GRAPHALG", then numNodes, numEdges, the numNodes+1
+//                      offsets and the numEdges neighbors of the csrGraph, all 32 bit ints
+//                      in the byte order of the machine that wrote the file.
+// GRAPH_FILE_AUTO tells them apart by the start of the file. In the text formats a #
+// starts a comment that runs to the end of the line.
+enum { GRAPH_FILE_AUTO, GRAPH_FILE_MATRIX, GRAPH_FILE_EDGES, GRAPH_FILE_BINARY };
+
+// Reads the graph in fileName into g. If fileName is NULL or "-" standard input is read.
+// Files are mapped with mmap and the numbers are parsed in place, so a graph with a
+// million edges loads in a fraction of a second. If formatRead is not NULL it is set
+// to the format the file was read as, which with GRAPH_FILE_AUTO is the one found.
+// Returns 1 on success and 0 if the file could not be read or is not a valid graph.
+int readGraph(const char *fileName, csrGraph &g, int format = GRAPH_FILE_AUTO, int withReverse = 0, int *formatRead = NULL);
+
+// Same as readGraph, for a file already in memory.
+int parseGraph(const char *buf, size_t len, csrGraph &g, int format = GRAPH_FILE_AUTO, int withReverse = 0, int *formatRead = NULL);
+
+// Writes g to fileName in the given format. Returns 1 on success.
+int writeGraph(const char *fileName, const csrGraph &g, int format = GRAPH_FILE_BINARY);
+
+// Internal functions for parseGraph. skipGraphSpace moves pos past white space and
+// comments. parseGraphInt then reads an int into value and moves pos past it.
+// It returns 0 if there is no int at pos.
+void skipGraphSpace(const char *&pos, const char *end);
+int parseGraphInt(const char *&pos, const char *end, int &value);
+
 // This uses DFS to find path from node a to node b.
 // If directed = 1, then the path is directed. directed = 0 means only find undirected paths
 list <int> getPath(int **adjMat, int numNodes, int a, int b, int directed);
+list <int> getPath(const csrGraph &g, int a, int b, int directed);
 
 // Internal DFS function for getPath.
 // Returns true if b is in one of its decendents.
@@ -56,12 +184,27 @@ int getPathDFS(int **adjMat, int numNodes, int curNode, int endNode, list <int>
 // This uses DFS to find all paths from node a to node b.
 // If directed = 1, then the path is directed. directed = 0 means only find undirected paths
 list <list <int> > getAllPaths(int **adjMat, int numNodes, int a, int b, int directed);
+list <list <int> > getAllPaths(const csrGraph &g, int a, int b, int directed);
 
 // Internal DFS function for getPath.
 // Returns true if b is in one of its decendents.
 // This will keep searching for all paths
 int getAllPathsDFS(int **adjMat, int numNodes, int curNode, int endNode, list <int> &curPath, list <list <int> > &allPaths, set <int> &markedNodes, int directed);
 
+// Like getAllPaths, but each path is passed to visit (the nodes, a first and b last,
+// and their number) as soon as it is found instead of being stored. The path array is
+// only valid during the call. If visit returns 0 the search stops. maxLength bounds
+// the number of nodes on a path, -1 means no limit. The paths come in the same order
+// as from getAllPaths.
+// The DFS uses an explicit stack and a bitset of the nodes on the path, so it needs
+// O(n) memory however many paths there are. Nodes that can not reach b, or not with
+// few enough nodes left, are never entered (the distances to b come from one
+// backward breadth first search; for directed = 1 it uses the reverse of g, copying g
+// if it has none).
+// Returns the number of paths visited.
+long long visitAllPaths(const csrGraph &g, int a, int b, int directed, int maxLength, const function <int (const int *, int)> &visit);
+long long visitAllPaths(int **adjMat, int numNodes, int a, int b, int directed, int maxLength, const function <int (const int *, int)> &visit);
+
 
 // This will take as input an adjacency matrix for a directed graph with numNodes nodes.
 // It will first run tarjan to decompose the graph into strongly connected components. 
@@ -73,10 +216,109 @@ int getAllPathsDFS(int **adjMat, int numNodes, int curNode, int endNode, list <i
 // However, if (i,j) is marked as a "back node" then it won't be reported currently as
 // a cycle of length 2. But, who cares for our application.
 list < list <int> > getMinCycles(int **adjMat,int numNodes);
+list < list <int> > getMinCycles(const csrGraph &g);
+
+// Internal function for getMinCycles. compGraph is one strongly connected component
+// relabelled 0 .. size-1 in increasing order, nodes gives the original labels. Runs
+// the DFS from node 0 with an explicit stack and adds a cycle for every non tree edge
+// to minCycles, read off the parent pointers. The edges that do not go back to an
+// ancestor give an empty list, as they always have.
+void minCyclesComponent(const csrGraph &compGraph, const vector <int> &nodes, list < list <int> > &minCycles);
+
+// A cycle basis of short directed cycles, as IP cuts tighter than the DFS cycles of
+// getMinCycles. Each strongly connected component with k nodes and m edges has a
+// cycle space of dimension m - k + 1 over GF(2), spanned by its directed cycles.
+// As in Horton's algorithm the candidates are, for every node v and edge u -> w, the
+// shortest path v -> u, the edge and the shortest path w -> v, when that is a simple
+// cycle. Only nodes above v are used, so every cycle is found from its smallest node.
+// The candidates are taken lightest first while they are independent of the ones
+// already taken. The cycles are kept as bitsets over the edges and tested by XOR
+// elimination a word at a time. weights gives the weight of every edge in the order of
+// the neighbors (see csrGraph::outOffset), NULL means every edge weighs 1. Self loops
+// are ignored. The cycles start with their smallest node and are listed component by
+// component, lightest first. A component takes O(k^2 + k m) memory for its search
+// trees and candidates, so this is meant for components of up to a few thousand nodes.
+list < list <int> > getMinCycleBasis(const csrGraph &g, const double *weights = NULL);
+list < list <int> > getMinCycleBasis(int **adjMat, int numNodes);
+
+// Internal function for getMinCycleBasis. g must be strongly connected and have no
+// self loops. Adds its basis to basis.
+void minCycleBasisComponent(const csrGraph &g, const double *weights, list < list <int> > &basis);
 
 
 // This returns a list of list of strongly connected components.
 list <set <int> > tarjan(int **adjMatrix, int numNodes);
+list <set <int> > tarjan(const csrGraph &g);
+
+// Iterative version of Tarjan's algorithm, so there is no recursion and it works
+// on graphs of any depth. Fills compId (numNodes entries, allocated by the caller)
+// with the strongly connected component of each node and returns the number of
+// components. Components are numbered in the order they are found, which is the
+// order of the list tarjan returns (a reverse topological order).
+int tarjanComponents(const csrGraph &g, int *compId);
+
+// Multi-threaded strongly connected components for large graphs. Trims nodes with
+// no in or out edges, then splits the rest with forward-backward searches
+// (Fleischer, Hendrickson, Pinar) run as tasks on numThreads threads. Parts smaller
+// than a few thousand nodes are finished with Tarjan's algorithm inside their task.
+// If numThreads <= 1 or the graph has fewer than minParallelNodes nodes this just
+// calls tarjanComponents, since there the threads cost more than they save.
+// Fills compId and returns the number of components like tarjanComponents, so the
+// partition is the same as tarjan's. The ids are not in tarjan's order though:
+// here components are numbered in increasing order of their smallest node (in
+// both the threaded and the sequential case), so the result is deterministic.
+// Uses the reverse of g; if g has none (see buildReverse) a copy is made.
+int parallelComponents(const csrGraph &g, int *compId, int numThreads, int minParallelNodes = 20000);
+
+// Returns 1 if g has no directed cycle, else 0. Runs one iterative three color DFS,
+// O(numNodes + numEdges), with no allocation beyond a few arrays of numNodes entries.
+// If the graph is acyclic and topoOrder is not NULL it gets a topological order (numNodes
+// entries, allocated by the caller). Otherwise if cycle is not NULL it gets one cycle
+// (at most numNodes entries, allocated by the caller) and cycleLength its number of nodes.
+// The cycle the DFS finds is cut down along its chords to one with no chords, and starts
+// with its smallest node. Unlike tarjan, a self loop counts as a cycle of length 1.
+int isAcyclic(const csrGraph &g, int *topoOrder = NULL, int *cycle = NULL, int *cycleLength = NULL);
+int isAcyclic(int **adjMat, int numNodes, int *topoOrder = NULL, int *cycle = NULL, int *cycleLength = NULL);
+
+// Returns the cycle isAcyclic gives, or an empty list if the graph is acyclic.
+list <int> findCycle(const csrGraph &g);
+list <int> findCycle(int **adjMat, int numNodes);
+
+// A cycle inequality sum_{e in C} x_e <= |C| - 1 violated by the LP solution x.
+struct violatedCycle
+{
+    vector <int> cycle; // The nodes in order, starting with the smallest.
+    double weight; // Sum of 1 - x_e over the edges of the cycle.
+    double violation; // sum x_e - (|C| - 1), which is 1 - weight.
+};
+
+// Separation of cycle inequalities for row generation. x gives the LP value of every
+// edge: for the csrGraph version one entry per edge in the order of the neighbors
+// (see outOffset), for the matrix version x[i][j] for each edge i -> j of adjMat.
+// An inequality is violated by at least minViolation exactly when its cycle weighs at
+// most 1 - minViolation with edge weights 1 - x (x above 1 counts as 1), so this looks
+// for light cycles instead of enumerating all of them. A Dijkstra search from every
+// node s over the nodes above s gives the lightest cycle with s as its smallest node.
+// Then Yen's k shortest paths algorithm takes the lightest cycles one at a time, each
+// one followed by the next candidates through its own s. Every cycle returned costs a
+// search per node of it, however many cycles there are. Returns the k most violated
+// cycles (k <= 0 means all of them) sorted by weight. Of the cycles that weigh the
+// same as the k-th, it is not said which are returned. Self loops are ignored.
+vector <violatedCycle> separateCycles(const csrGraph &g, const double *x, int k, double minViolation = 1e-6);
+vector <violatedCycle> separateCycles(int **adjMat, double **x, int numNodes, int k, double minViolation = 1e-6);
+
+// Orders violated cycles by weight, then by the nodes.
+struct violatedCycleLighter
+{
+    bool operator()(const violatedCycle &one, const violatedCycle &two) const
+    {
+        if (one.weight != two.weight)
+        {
+            return one.weight < two.weight;
+        }
+        return one.cycle < two.cycle;
+    }
+};
 
 // Recursive function that does the hard work. Performs DFS and records extra information.
 void strongConnect(int **adjMatrix, int *nodeIndex, int *nodeLowlink, int numNodes, int curNode, int &index, list <int> &myQueue, set <int> &myQueueContents, list < set <int> > &strongConComps);
@@ -126,10 +368,22 @@ int **copyAdjMat(int **adjMat, int numNodes);
 
 // Use the orientation rules from "Causal inference and causal explanation with background knowledge"
 // Meek 1995. Also in "Characteristic imsets for learning Bayesian network structures", Hemmecke et. al.
+// An undirected edge i - j has patMat[i][j] = patMat[j][i] = 1, a directed one i -> j only
+// patMat[i][j] = 1. Returns a new matrix (see allocateAdjMat) with the edges rules R1 - R4
+// orient directed. Up to user to delete.
+// Only the undirected edges near a newly oriented edge are checked again, and the rules are
+// tested on bitsets of the parents, children, undirected neighbors and adjacent nodes.
 int **essGraphFromPatGraph(int **patMat, int numNodes);
 
+// Returns a DAG in the class of the partially directed graph pdagMat (same form as patMat above),
+// using the extension algorithm from "A simple algorithm to construct a consistent extension of a
+// partially oriented graph", Dor and Tarsi 1992. Returns a new matrix with every undirected edge
+// oriented, up to user to delete, or NULL if no consistent extension exists.
+// Sink candidates are kept on a worklist and only nodes next to a removed sink are checked again.
+int **pdagToDag(int **pdagMat, int numNodes);
+
 // Returns true if x is in myList.
-int isInList(int x, list <int> myList);
+int isInList(int x, const list <int> &myList);
 
 
 // Compares the two lists and returns 1 if they are equal.
@@ -201,23 +455,105 @@ struct eqListInt
     }
 };
 
-// Computes the has of a set of ints by converting to a string then hashing.
+// Computes the hash of a list of ints (FNV-1a over the values).
 struct hashListInt
 {
-    size_t operator()(const list <int> myList) const
+    size_t operator()(const list <int> &myList) const
     {
-        hash <const char *> H;
-        size_t retVal;
-        char *subString = listToString(myList);
-        retVal = H(subString);
-        delete [] subString;
+        uint64_t retVal = 0xcbf29ce484222325ULL;
+        list <int>::const_iterator lit;
+        for (lit=myList.begin();lit!=myList.end();lit++)
+        {
+            retVal = (retVal ^ (uint32_t)(*lit)) * 0x100000001b3ULL;
+        }
         return retVal;
     }
 };
 
+// The canonical form of a cycle is the one uniqueBiDirCycle gives: start at
+// the smallest node and go towards the smaller of its two neighbors on the cycle.
+// These work on the cycle in place, without building the canonical form.
+
+// Hash of the canonical form of the cycle, so all rotations and both directions
+// of a cycle get the same value.
+uint64_t hashCycle(const int *cycle, int length);
+
+// Returns 1 if the two cycles have the same canonical form.
+int cyclesEqual(const int *cycleOne, int lengthOne, const int *cycleTwo, int lengthTwo);
+
+// A hash set of cycles up to rotation and direction. The cycles are stored in
+// canonical form back to back in one array and the table only holds their hash
+// and position, so a lookup allocates nothing.
+class cycleHashSet
+{
+    public:
+        cycleHashSet(); //Constructor
+        int insert(const int *cycle, int length); // Adds the cycle. Returns 1 if it was not in the set yet.
+        int contains(const int *cycle, int length); // Returns 1 if the cycle is in the set.
+        int size() { return cycleStart.size() - 1; }
+        size_t bytes(); // Memory held by the set.
+        void clear ();
+        void getCycle(int k, list <int> &cycle); // Puts the canonical form of the k-th cycle added in cycle.
+        int save(FILE *out); // Writes the cycles to out. Returns 0 if it failed.
+        int load(FILE *in); // Replaces the set with the cycles save wrote. Returns 0 if it failed.
+    private:
+        int findSlot(const int *cycle, int length, uint64_t hash); // The slot holding the cycle, or the empty slot
+                                                                    // where it would go.
+        void grow(); // Doubles the table.
+        vector <uint64_t> slotHash;
+        vector <int> slotCycle; // Which cycle is in each slot, -1 if empty.
+        vector <int> cycleStart; // Cycle k is storage[cycleStart[k]] .. storage[cycleStart[k+1]-1].
+        vector <int> storage;
+};
+
 // Returns 1 if the graphs are the same
 int graphSame(int **adjMatOne, int **adjMatTwo, int numNodes);
 
+// One path in the queue of cycleGenerator. The path is its parent's path followed
+// by tail, so a path of length k costs one record instead of k list nodes and is
+// only written out when it turns out to be a cycle.
+struct pathRecord
+{
+    int parent;  // Index of the parent path in the queue, -1 for a single node.
+    int tail;    // The last node of the path.
+    int head;    // The first (and smallest) node of the path.
+    int length;  // The number of nodes in the path.
+    uint64_t pathBits; // If numNodes <= 64 the set of nodes on the path, otherwise 0.
+};
+
+// The most records the queue of cycleGenerator holds in memory, since they refer to
+// each other by int indices. Past that the queue is spilled to files (see
+// cycleGenerator::setMemoryLimit), even without a memory limit.
+const size_t PATH_QUEUE_MAX_RECORDS = INT_MAX;
+
+// Orders pathRecords by length, the order they have in the queue.
+struct pathRecordShorter
+{
+    bool operator()(const pathRecord &one, const pathRecord &two) const
+    {
+        return one.length < two.length;
+    }
+};
+
+// A snapshot of a cycleGenerator run, see cycleGenerator::getStats. Watching
+// queueRecords and bytesHeld shows a run that is about to run out of memory.
+struct cycleGeneratorStats
+{
+    int pathLength; // The length of the paths being extended now, 0 before the first step and when all are done.
+    long long steps; // The number of paths extended so far.
+    long long queuedPaths; // Paths waiting to be extended, in memory or spilled.
+    long long queueRecords; // Records in the path queue: the queued paths and their ancestors.
+    long long peakQueueRecords; // The most records the path queue has held.
+    long long duplicateCycles; // Bi-directed cycles dropped because their reverse was already found.
+    long long cyclesReturned; // Cycles nextCycle has returned.
+    size_t bytesHeld; // Memory held by the path queue, the cycles not yet returned, the hash set of
+                      // bi-directed cycles and the tables built from the graph. Not the graph itself.
+    long long bytesSpilled; // Bytes of queued paths in spill files (see setMemoryLimit).
+    vector <long long> cyclesByLength; // cyclesByLength[k] cycles of length k have been found.
+    vector <double> secondsByLength; // secondsByLength[k] seconds were spent extending paths of length k.
+    double seconds; // Seconds since the first step.
+};
+
 // This is a class which will output cycles in increasing size.
 // Uses the algorithm in "A new way to enumerate cycles in graph"
 // by Hongbo Liu and Jiaxin Wang.
@@ -229,6 +565,16 @@ int graphSame(int **adjMatOne, int **adjMatTwo, int numNodes);
 // This class deletes its allocated memory when done. Note that
 // it only *copies* the adjMat it is given. Thus, be sure to 
 // delete the copy you gave this class.
+// It can also be given a csrGraph. Internally the graph is always kept as a
+// csrGraph, and if the graph is dense enough also as bit-packed rows, so the
+// possible extensions of a path are found a word (64 nodes) at a time.
+// The queue of open paths is a single array of pathRecords with parent
+// pointers (see pathRecord), so extending a path costs one record.
+// With setNumThreads(x), x > 1, batches of paths of the same length are extended
+// at once by x threads, each into its own buffer. The buffers are joined in order,
+// so the cycles come out exactly as with one thread.
+// With setMemoryLimit the path queue is moved to files once it gets too big, see
+// below. A long run can be saved with save and carried on later with load.
 // Once initialized, the main function is nextCycle. It will return 
 // the next cycle starting with cardinality 2. If there are no more 
 // cycles to return it returns an empty list.
@@ -240,8 +586,10 @@ class cycleGenerator
         cycleGenerator(); //Constructor
         ~cycleGenerator(); //Destructor
         cycleGenerator(int **someAdjMat,int someNumNodes);
+        cycleGenerator(const csrGraph &someGraph);
         void print (); // Prints the adj matrix,
         void copyAdjMatInt(int **someAdjMat,int someNumNodes);// Copies someAdjMat
+        void copyGraph(const csrGraph &someGraph); // Copies someGraph
         void clear (); // Clears all data structures, including the adjMat.
 
         int oneStep (); // Runs one step of the algorithm. Returns 1 if successful
@@ -257,22 +605,344 @@ class cycleGenerator
         void printUniqBiDirectedCycles(); // Prints out the list of unique bi-directed cycles
         int sizeUniqBiDirectedCycles(); // Returns the current size of uniqBiDirectedCycles
         void setCycleLengthMin(int x); // Sets cycleLengthMin
+        void setCycleLengthMax(int x); // Sets cycleLengthMax. -1 (the default) means no limit. Call it
+                                       // before the first nextCycle.
+        void setNumThreads(int x); // Sets numThreads
+        cycleGeneratorStats getStats(); // Returns the statistics of the run so far.
+        void setProgressCallback(const function <void (const cycleGeneratorStats &)> &callback, long long everySteps);
+                                        // Calls callback with getStats() every time everySteps more paths have
+                                        // been extended. An empty callback turns it off.
+        int setMemoryLimit(size_t bytes, const char *tempDir = NULL);
+                                        // Keeps the path queue under about bytes bytes, 0 (the default) means
+                                        // no limit. When extending a path would grow the queue past it, the
+                                        // queued paths are written to a file in tempDir (NULL means /tmp), each
+                                        // as its nodes in 2 or 4 bytes, and from then on the paths of each
+                                        // length are read from one file while their extensions are written to
+                                        // the next. The cycles come out in the same order. Once on disk the
+                                        // paths are extended one at a time, without threads. The files are
+                                        // unlinked as soon as they are made. Returns 0, and sets no limit, if
+                                        // no file can be made in tempDir.
+        int spillError(); // Returns 1 if a spill file could not be written or read, or the queue grew to
+                          // PATH_QUEUE_MAX_RECORDS and could not be spilled. The run stops there.
+        int save(const char *fileName); // Writes a checkpoint of the run: the graph, the settings the cycles
+                                        // depend on, the path queue (spilled or not), the cycles found but not
+                                        // returned, the bi-directed cycles seen and the statistics, in binary.
+                                        // It goes to fileName.tmp first and is then renamed, so an older
+                                        // checkpoint is only replaced by a whole one. Returns 0 if it failed.
+        int load(const char *fileName); // Replaces everything with the run saved in fileName. nextCycle then
+                                        // returns what it would have returned next in the saved run. The
+                                        // hashBiDirectedCycles, cycleLengthMin and cycleLengthMax of the saved
+                                        // run are loaded, the other settings are kept. A spilled queue goes to
+                                        // new files in the directory of setMemoryLimit. Returns 0, and leaves
+                                        // the generator cleared, if it failed.
     private:
+        cycleGenerator(const cycleGenerator &); // Not copyable, it may own files.
+        cycleGenerator &operator=(const cycleGenerator &);
         void init();
-        int **adjMat;
+        void checkProgress(); // Updates peakQueueRecords and calls progressCallback if it is due.
+        void endLevel(); // Adds the time spent on the current length to secondsByLength.
+        int expandLevel(); // Extends the next batch of queued paths of the current length using numThreads threads.
+                           // Returns 0 (and does nothing) if there are too few of them to bother.
+        void startPath(); // Called before extending pathQueue[pathQueueFront]. Compacts at a new length.
+        void extendPath(int index, uint64_t *mask, vector <pathRecord> &newPaths); // Appends the extensions of
+                                                                                  // pathQueue[index] to newPaths.
+        void addCycle(int index); // pathQueue[index] closes a cycle. Adds it to cyclesFound if it should be returned.
+        void addCycle(const int *path, int length); // The same for a path given by its nodes.
+        int spillNeeded(); // Returns 1 if extending a path could grow pathQueue past memoryLimit.
+        void spillPathQueue(); // Moves the queued paths from pathQueue to spillRead and spillWrite.
+        int spilledStep(); // oneStep once the paths are in files.
+        void extendSpilledPath(int length); // Writes the extensions of spillPath to spillWrite.
+        FILE *openSpillFile(); // A new unlinked file in spillDir, NULL if it can not be made.
+        int writeSpilledPath(FILE *spillFile, const int *path, int length); // Returns 0 if it failed.
+        int readSpilledPath(FILE *spillFile, int *path, int length); // Returns 0 if it failed.
+        void closeSpillFiles();
+        int isCycleBiDirected(const int *myCycle, int length); // Returns 1 if the reverse is also a cycle.
+        vector <int> cycleNodes; // Scratch space for the cycle addCycle is looking at.
+        csrGraph graph;
         int numNodes;
         void addVertToPathQueue();
-        int oneStepCalls;
+        void getQueuedPath(int index, list <int> &path); // Writes out the path of pathQueue[index].
+        void compactPathQueue(); // Drops the records that are not an ancestor of a queued path.
+        void buildBitRows(); // Fills adjBits from graph if the graph is dense enough.
+        void buildCloseDistances(); // Fills the close arrays for cycleLengthMax.
+        int closeDistance(int head, int v); // The distance from v back to head, or cycleLengthMax if more.
+        int hasEdge(int a, int b) { return useBitRows == 1 ? testBit(adjBits.data() + (size_t)a*numWords, b) : graph.hasEdge(a,b); }
+        int useBitRows; // 1 means adjBits holds the graph, one row of numWords words per node.
+        int numWords;
+        vector <uint64_t> adjBits;
+        vector <uint64_t> pathMask; // Scratch bitset of the nodes on the path being extended. Kept all 0.
+        long long oneStepCalls;
+        int numThreads; // Threads used to extend a whole length at once. Default is 1.
+        graphThreadPool *threadPool; // The numThreads threads expandLevel runs on. Made by setNumThreads, NULL for 1 thread.
         int cycleLengthMin; // The minimum length of cycles to return. Default is 1
+        int cycleLengthMax; // The maximum length of cycles to return. Default is -1, no limit.
+        // With cycleLengthMax set, a path is only extended to v if v can get back to its head
+        // soon enough. closeNodes[closeOffsets[h]] .. closeNodes[closeOffsets[h+1]-1] are the
+        // nodes above h less than cycleLengthMax steps from h through nodes above h, sorted,
+        // and closeDist has their distances.
+        vector <int> closeOffsets;
+        vector <int> closeNodes;
+        vector <int> closeDist;
         int hashBiDirectedCycles; // 1 means save biDirected cycles. This is so we can print out
                                   // unique cycles. Default is no
 
-        list < list <int> > pathQueue;
+        vector <pathRecord> pathQueue; // The records from pathQueueFront on are the paths still to
+                                       // be extended, the ones before are kept as their ancestors.
+        int pathQueueFront;
+        int pathQueueLength; // The length of the paths being extended. Used to compact once per length.
         list < list <int> > cyclesFound; // We store cycles as a list of the nodes encountered. We do not repeat head.
                                          // Implicit that it is a cycle.
-        hash_set< list <int> , hashListInt , eqListInt> uniqBiDirectedCycles; // This will save the bi-directed cycles.
-                                                                          // if hashBiDirectedCycles is 1.
+        cycleHashSet uniqBiDirectedCycles; // This will save the bi-directed cycles.
+                                           // if hashBiDirectedCycles is 1.
+
+        // Statistics, see cycleGeneratorStats.
+        long long peakQueueRecords;
+        long long duplicateCycles;
+        long long cyclesReturned;
+        long long cyclesFoundNodes; // The number of nodes of the cycles in cyclesFound.
+        vector <long long> cyclesByLength;
+        vector <double> secondsByLength;
+        chrono::steady_clock::time_point runStartTime; // When the first step was taken.
+        chrono::steady_clock::time_point levelStartTime; // When the paths of length pathQueueLength were started.
+        function <void (const cycleGeneratorStats &)> progressCallback;
+        long long progressEverySteps;
+        long long nextProgressStep; // progressCallback is called when oneStepCalls gets here.
+
+        // Spilling the path queue, see setMemoryLimit.
+        size_t memoryLimit; // 0 means no limit.
+        string spillDir;
+        int spillNodeBytes; // 2 if every node fits in 16 bits, otherwise 4.
+        FILE *spillRead; // The queued paths of length spillLength, NULL if the paths are in pathQueue.
+        FILE *spillWrite; // Their extensions, of length spillLength + 1.
+        int spillLength;
+        long long spillReadLeft; // Paths not yet read from spillRead.
+        long long spillWriteCount; // Paths written to spillWrite.
+        int spillFailed;
+        vector <int> spillPath; // Scratch space for the path being extended and one more node.
+        vector <unsigned char> spillBuffer; // Scratch space for a path as it is in the file.
+};
 
+// Every directed cycle lies inside one strongly connected component. This class
+// runs tarjan, copies each component with more than one node into its own small
+// graph (renumbered in the same order, so cycles still start with their smallest
+// node) and gives each to a cycleGenerator. nextCycle returns the cycles in
+// increasing size like cycleGenerator, and within a size component by component.
+// With one thread the components are asked for cycles only as they are needed.
+// With numThreads > 1 all cycles of one size are collected from every component
+// at once (each component by one thread), so the order does not depend on the
+// threads, but each component runs through all cycles of the last size asked for.
+// Nodes outside the non trivial components never enter a path queue.
+class sccCycleGenerator
+{
+    public:
+        sccCycleGenerator(); //Constructor
+        ~sccCycleGenerator(); //Destructor
+        sccCycleGenerator(int **someAdjMat,int someNumNodes);
+        sccCycleGenerator(const csrGraph &someGraph);
+        void print (); // Prints the adj matrix,
+        void copyAdjMatInt(int **someAdjMat,int someNumNodes);// Copies someAdjMat
+        void copyGraph(const csrGraph &someGraph); // Copies someGraph
+        void clear (); // Clears all data structures, including the graph.
+
+        list <int> nextCycle(); // This returns the next cycle, by cardinality. Empty if there are no more.
+        int numComponents(); // Returns the number of non trivial strongly connected components.
+        void setHashBiDirectedCycles(int x); // Sets hashBiDirectedCycles to x
+        void setCycleLengthMin(int x); // Sets cycleLengthMin
+        void setCycleLengthMax(int x); // Sets cycleLengthMax. -1 (the default) means no limit.
+        void setNumThreads(int x); // Sets numThreads. Default is 1.
+    private:
+        sccCycleGenerator(const sccCycleGenerator &); // Not copyable
+        sccCycleGenerator &operator=(const sccCycleGenerator &);
+        void init();
+        void deleteComponents();
+        int collectNextLength(); // Starts on the next size. With numThreads > 1 moves all cycles of it into
+                                 // cyclesFound, otherwise sets streamComps. Returns 0 if there are no more cycles.
+        void runOnComponents(const vector <int> &comps, const function <void (int)> &work); // Runs work(comp) for each comp,
+                                                                                         // using numThreads threads.
+        csrGraph graph;
+        int numNodes;
+        int hashBiDirectedCycles;
+        int cycleLengthMin;
+        int cycleLengthMax;
+        int numThreads;
+        graphThreadPool *threadPool; // The numThreads threads runOnComponents uses. Made by setNumThreads, NULL for 1 thread.
+
+        vector <cycleGenerator *> compGens; // One cycleGenerator per non trivial component.
+        vector < vector <int> > compNodes;  // compNodes[c][i] is the node of graph that is node i of component c.
+        vector < list <int> > nextCompCycle; // The next cycle of each component, not yet returned.
+        vector <char> compDone; // 1 if component c has no more cycles.
+        list < list <int> > cyclesFound; // The cycles of the current size, in the original numbering.
+        int curLength; // The current size.
+        vector <int> streamComps; // With one thread, the components with cycles of the current size.
+        int streamPos; // The one of streamComps currently returning cycles.
+};
+
+// This is a class which outputs all directed cycles using the algorithm in
+// "Finding all the elementary circuits of a directed graph" by Donald B. Johnson.
+// It has the same nextCycle contract as cycleGenerator: each cycle starts with its
+// smallest node and an empty list means there are no more cycles. Unlike
+// cycleGenerator the cycles do *not* come out in increasing size. In exchange it
+// only keeps O(n + m) state instead of every open path, and takes O((n + m)(c + 1))
+// time for c cycles, so it is much faster on graphs with few cycles but many paths.
+// For each start node s in turn it searches the strongly connected component of s
+// in the graph induced by the nodes >= s, blocking nodes that can not currently
+// get back to s. The components of the whole graph are found once with
+// tarjanComponents: nodes alone in theirs are never start nodes, and the search
+// from s only looks at the nodes in the same component of the whole graph as s.
+// With setCycleLengthMax the searches only go as far as a cycle that is short enough
+// can, and a path is not extended to a node that is too far from s to close in time.
+// setHashBiDirectedCycles and setCycleLengthMin mean the same as for cycleGenerator
+// (here the two orientations of a bi-directed cycle are told apart without a hash:
+// the one whose second node is smaller than its last node is kept).
+class johnsonCycleGenerator
+{
+    public:
+        johnsonCycleGenerator(); //Constructor
+        ~johnsonCycleGenerator(); //Destructor
+        johnsonCycleGenerator(int **someAdjMat,int someNumNodes);
+        johnsonCycleGenerator(const csrGraph &someGraph);
+        void print (); // Prints the adj matrix,
+        void copyAdjMatInt(int **someAdjMat,int someNumNodes);// Copies someAdjMat
+        void copyGraph(const csrGraph &someGraph); // Copies someGraph
+        void clear (); // Clears all data structures, including the graph.
+
+        list <int> nextCycle(); // This returns the next cycle, or an empty list if there are no more.
+        int findCycle(); // Like nextCycle but does not build a list. Returns 1 if a cycle was found,
+                         // it is then given by currentCycle. Returns 0 if there are no more.
+        const vector <int> &currentCycle() { return path; } // The cycle findCycle found.
+        void setHashBiDirectedCycles(int x); // Sets hashBiDirectedCycles to x
+        void setCycleLengthMin(int x); // Sets cycleLengthMin
+        void setCycleLengthMax(int x); // Sets cycleLengthMax. -1 (the default) means no limit. Call it
+                                       // before the first findCycle.
+    private:
+        void init();
+        void restart(); // Starts the enumeration over.
+        int nextStartNode(); // Moves startNode on to the next node with a non trivial component. Returns 0 if none is left.
+        void unblock(int u);
+        csrGraph graph; // Has the reverse graph too, for finding components.
+        int numNodes;
+        int hashBiDirectedCycles; // 1 means only return one orientation of bi-directed cycles. Default is no
+        int cycleLengthMin; // The minimum length of cycles to return. Default is 1
+        int cycleLengthMax; // The maximum length of cycles to return. Default is -1, no limit.
+
+        vector <int> compId; // The strongly connected component of each node in the whole graph, by tarjanComponents.
+        vector <int> compSize; // The number of nodes of each component. Start nodes alone in theirs are skipped.
+        int startNode; // The smallest node of the cycles currently being searched for.
+        vector <int> forwardMark; // forwardMark[v] == startNode if v can be reached from startNode.
+        vector <int> forwardDist; // The distance from startNode to v, if forwardMark[v] == startNode.
+        vector <int> backwardMark; // backwardMark[v] == startNode if the backward search reached v.
+        vector <int> backDist; // The distance from v back to startNode, if backwardMark[v] == startNode.
+        vector <int> inComp; // inComp[v] == startNode if v is in the component of startNode.
+        vector <char> blocked;
+        vector < vector <int> > blockedBy; // Johnson's B lists: blockedBy[w] are blocked nodes to unblock with w.
+        vector <int> path; // The current path, startNode first.
+        vector <const int *> nextNeighbor; // nextNeighbor[k] is the next neighbor of path[k] to try.
+        vector <char> foundCycle; // foundCycle[k] is 1 if a cycle was found through path[k] (so it must be unblocked).
+};
+
+// Counts the directed cycles of each length without listing them. Entry k of the
+// result is the number of cycles with k nodes, for k up to maxLength (-1 means no
+// limit). Self loops are not counted and the two orientations of a bi-directed cycle
+// count as two cycles, so this is what draining a cycleGenerator with
+// setCycleLengthMin(2) would give. Each strongly connected component is counted on
+// its own. Components of at most COUNT_SUBSET_MAX_NODES nodes are counted by
+// dynamic programming over subsets, which takes the same time however many cycles
+// there are. Larger ones are run through johnsonCycleGenerator::findCycle, which
+// keeps O(n + m) memory and only builds its current path. With maxLength set it
+// only searches around each node as far as a cycle of maxLength nodes reaches.
+vector <long long> countCyclesByLength(const csrGraph &g, int maxLength = -1);
+vector <long long> countCyclesByLength(int **adjMat, int numNodes, int maxLength = -1);
+
+// Internal function for countCyclesByLength. Adds the cycles of g to counts by the
+// subset dynamic program. g must have at most COUNT_SUBSET_MAX_NODES nodes.
+void countCyclesSubsets(const csrGraph &g, int maxLength, vector <long long> &counts);
+
+// Answers "is there a path from a to b" in O(1). The strongly connected components
+// are found with tarjanComponents, then every component gets a bitset row of the
+// components it reaches. Since tarjanComponents numbers the components in reverse
+// topological order, the rows of the successors of a component are done before its
+// own and it is the OR of them. A successor that is already in the row is skipped,
+// since its whole row is in there too. This takes O(c^2 / 8) bytes for c components.
+// addEdge updates the rows instead of starting over: every row that reaches the
+// tail gets the row of the head ORed in. Components that become strongly connected
+// this way are not merged; they just get the same rows.
+class reachabilityIndex
+{
+    public:
+        reachabilityIndex(); //Constructor
+        reachabilityIndex(int **someAdjMat, int someNumNodes);
+        reachabilityIndex(const csrGraph &someGraph);
+        void copyAdjMatInt(int **someAdjMat, int someNumNodes); // Builds the index of someAdjMat
+        void copyGraph(const csrGraph &someGraph); // Builds the index of someGraph
+        void clear (); // Empties the index.
+
+        // Returns 1 if there is a directed path from a to b. Every node reaches itself.
+        int reachable(int a, int b) { return testBit(reach.data() + (size_t)compId[a]*numWords, compId[b]); }
+        void addEdge(int a, int b); // Updates the index for a new edge a -> b.
+        int getNumNodes() { return numNodes; }
+    private:
+        int numNodes;
+        int numComps;
+        int numWords; // Words per row.
+        vector <int> compId;
+        vector <uint64_t> reach; // Row c is the components c reaches.
+};
+
+// Keeps the strongly connected components of a graph up to date while edges are
+// added and removed, instead of running tarjan again after every change.
+// The components are kept in a topological order given by labels with gaps
+// between them (an edge between two components always goes to a higher label).
+// Adding an edge that goes against the order searches only the components with
+// labels between its two ends (Pearce and Kelly, "A dynamic topological sort
+// algorithm for directed acyclic graphs"). The components on a new cycle are
+// merged and the others moved, reusing their labels. Removing an edge inside a
+// component reruns Tarjan's algorithm on that component only and gives the pieces
+// labels in the gap the component had. All other changes are O(degree).
+// Component ids stay the same until the component is merged or split. Freed ids
+// are reused, so they are not 0 .. numComponents()-1.
+class dynamicSCC
+{
+    public:
+        dynamicSCC(); //Constructor
+        dynamicSCC(int **someAdjMat, int someNumNodes);
+        dynamicSCC(const csrGraph &someGraph);
+        void copyAdjMatInt(int **someAdjMat, int someNumNodes); // Starts over with the graph someAdjMat
+        void copyGraph(const csrGraph &someGraph); // Starts over with the graph someGraph
+        void clear (); // Empties the graph.
+
+        int addEdge(int a, int b); // Adds the edge a -> b. Returns 0 if it was already there.
+        int removeEdge(int a, int b); // Removes the edge a -> b. Returns 0 if it was not there.
+        int hasEdge(int a, int b); // Returns 1 if the edge a -> b exists.
+
+        int getNumNodes() { return numNodes; }
+        int numComponents() { return numComps; }
+        int getComponent(int v) { return compOf[v]; } // The id of the component of v.
+        int sameComponent(int a, int b) { return compOf[a] == compOf[b] ? 1 : 0; }
+        list <set <int> > components(); // The components in a reverse topological order. It is not
+                                        // necessarily the order tarjan gives.
+    private:
+        void reorder(int tailComp, int headComp); // Fixes the order after an edge tailComp -> headComp
+                                                  // was added against it.
+        int stillReaches(int a, int b); // Returns 1 if a reaches b inside their component.
+        void splitComponent(int comp); // Reruns Tarjan's algorithm on comp after an edge in it was removed.
+        int newComponent(); // Returns an unused component id.
+        void setLabel(int comp, long long label);
+        void relabelAll(); // Spreads the labels out again when a gap is used up.
+
+        int numNodes;
+        int numComps;
+        vector < vector <int> > outEdges;
+        vector < vector <int> > inEdges;
+        vector <int> compOf; // The component of each node.
+        vector < vector <int> > compNodes; // The nodes of each component. Empty for unused ids.
+        vector <long long> compLabel;
+        vector <int> freeComps; // Unused component ids.
+        map <long long,int> labelOrder; // The components by label.
+        vector <int> forwardMark; // Visit stamps of the searches in reorder.
+        vector <int> backwardMark;
+        vector <int> nodeForwardMark; // Visit stamps of the search in stillReaches.
+        vector <int> nodeBackwardMark;
+        int curStamp;
 };
 
 #endif
@@ -33,23 +33,22 @@
 // all minimum cycles (though it may miss some cycles of length 2).
 
 // ./graphalgtest < mat1.txt
+// The graph can also be given as a file in any of the formats
+// readGraph knows.
+// ./graphalgtest graph.bin
 
 using namespace std;
 
 int main (int argc, char *argv[])
 {
-    int numNodes;
-    cin >> numNodes;
-
-    int **adjMat = allocateAdjMat(numNodes);
-
-    for (int i=0;i<numNodes;i++)
+    csrGraph graph;
+    if (readGraph(argc > 1 ? argv[1] : NULL,graph) == 0)
     {
-        for (int j=0;j<numNodes;j++)
-        {
-            cin >> adjMat[i][j];
-        }
+        cerr << "Could not read a graph" << endl;
+        return 1;
     }
+    int numNodes = graph.getNumNodes();
+    int **adjMat = graph.toAdjMat();
     printMat(adjMat,numNodes);
 
     list <list <int> > minCycles = getMinCycles(adjMat,numNodes);
@@ -22,11 +22,53 @@
 
 // This program reads in an adjacency graph and outputs
 // the directed cycles. Optionally a limit on the cycle
-// size can be given as a command line argument.
+// size can be given as a command line argument. Paths that
+// can not close into a cycle within the limit are then not
+// searched at all.
+// With -j the cycles are found with Johnson's algorithm
+// (johnsonCycleGenerator) instead. It is much faster when
+// there are few cycles but many paths, but then the cycles
+// are not listed in increasing size.
+// With -t <num threads> cycleGenerator extends the paths of
+// each length with that many threads. The output is the same.
+// With -c each non trivial strongly connected component is
+// enumerated on its own (sccCycleGenerator), with -t giving
+// the number of components searched at once. The cycles are
+// still listed in increasing size.
+// With -f <file> the graph is read from the file instead of
+// standard input. Besides the adjacency matrix it can be an
+// edge list or binary graph file (see readGraph), which is
+// found from the start of the file. -e or -b force the edge
+// list or binary format. -w <file> writes the graph to a
+// binary file and exits. The graph is only printed before
+// the cycles when it was read as an adjacency matrix.
+// With -n only the number of cycles of each size is printed,
+// one "<size> <number>" line per size, without listing them
+// (see countCyclesByLength).
+// With -p <steps> cycleGenerator writes a progress line to
+// standard error every time it has extended that many more
+// paths, and with -s it writes its statistics there at the
+// end (see cycleGeneratorStats). Neither applies to -j or -c.
+// With -m <megabytes> the path queue of cycleGenerator is kept
+// under that size by moving it to files in /tmp, or in the
+// directory given with -d <dir> (see setMemoryLimit). Like
+// --resume, -m and -d can not be used with -j, -c, -n or -w.
+// With --checkpoint <file> the state of cycleGenerator is
+// saved to the file every 10 minutes, or every <seconds> given
+// with --checkpoint-every. --resume <file> carries on from a
+// checkpoint instead of reading a graph. It prints the cycles
+// that came after the ones printed when the checkpoint was
+// made (the number is written to standard error), so they can
+// be appended to that many cycle lines of the first output.
+// When the run finishes the checkpoint file is removed. If it
+// stops on a path queue file error the last checkpoint is kept,
+// and the number of cycles it comes after is written to
+// standard error.
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
+#include <chrono>
 #include "graphalg.h"
 
 
@@ -35,27 +77,149 @@
 // To limit the cycles to size of three.
 // ./listdircycles 3 < mat1.txt
 
+// To use Johnson's algorithm.
+// ./listdircycles -j 3 < mat1.txt
+
+// To use 8 threads.
+// ./listdircycles -t 8 3 < mat1.txt
+
+// To watch the path queue every million paths.
+// ./listdircycles -p 1000000 -s 8 < mat1.txt
+
+// To keep the path queue under 4GB, spilling to /scratch.
+// ./listdircycles -m 4096 -d /scratch 10 < mat1.txt
+
+// To save a checkpoint every hour and carry on after a crash.
+// ./listdircycles --checkpoint run.ckpt --checkpoint-every 3600 10 < mat1.txt > cycles.txt
+// ./listdircycles --resume run.ckpt --checkpoint run.ckpt > rest.txt
+
+// To convert a graph to a binary file and read it back.
+// ./listdircycles -w graph.bin < edges.txt
+// ./listdircycles -f graph.bin 3
+
 using namespace std;
 
-int main (int argc, char *argv[])
+// Writes one line of the statistics of a cycleGenerator to standard error.
+void printProgress(const cycleGeneratorStats &stats)
 {
-    int numNodes;
-    cin >> numNodes;
+    cerr << "length " << stats.pathLength << " steps " << stats.steps;
+    cerr << " queued " << stats.queuedPaths << " records " << stats.queueRecords;
+    cerr << " peak " << stats.peakQueueRecords << " bytes " << stats.bytesHeld << " spilled " << stats.bytesSpilled;
+    cerr << " duplicates " << stats.duplicateCycles << " seconds " << stats.seconds << endl;
+}
 
-    int **adjMat = allocateAdjMat(numNodes);
+int main (int argc, char *argv[])
+{
     int maxCycleSize = -1; // -1 means print all cycles.
+    int useJohnson = 0;
+    int useComponents = 0;
+    int countOnly = 0;
+    int numThreads = 1;
+    int printStats = 0;
+    long long progressSteps = 0; // 0 means no progress lines.
+    double memoryLimitMB = 0; // 0 means no limit.
+    const char *spillDir = NULL;
+    const char *checkpointFile = NULL;
+    const char *resumeFile = NULL;
+    double checkpointSeconds = 600;
+    const char *inFile = NULL; // NULL is standard input.
+    const char *outFile = NULL;
+    int format = GRAPH_FILE_AUTO;
+
+    for (int i=1;i<argc;i++)
+    {
+        if (strcmp(argv[i],"-j") == 0)
+        {
+            useJohnson = 1;
+        }
+        else if (strcmp(argv[i],"-c") == 0)
+        {
+            useComponents = 1;
+        }
+        else if (strcmp(argv[i],"-n") == 0)
+        {
+            countOnly = 1;
+        }
+        else if (strcmp(argv[i],"-s") == 0)
+        {
+            printStats = 1;
+        }
+        else if (strcmp(argv[i],"-p") == 0 && i+1 < argc)
+        {
+            progressSteps = atoll(argv[++i]);
+        }
+        else if (strcmp(argv[i],"-m") == 0 && i+1 < argc)
+        {
+            memoryLimitMB = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i],"-d") == 0 && i+1 < argc)
+        {
+            spillDir = argv[++i];
+        }
+        else if (strcmp(argv[i],"--checkpoint") == 0 && i+1 < argc)
+        {
+            checkpointFile = argv[++i];
+        }
+        else if (strcmp(argv[i],"--checkpoint-every") == 0 && i+1 < argc)
+        {
+            checkpointSeconds = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i],"--resume") == 0 && i+1 < argc)
+        {
+            resumeFile = argv[++i];
+        }
+        else if (strcmp(argv[i],"-t") == 0 && i+1 < argc)
+        {
+            numThreads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i],"-f") == 0 && i+1 < argc)
+        {
+            inFile = argv[++i];
+        }
+        else if (strcmp(argv[i],"-w") == 0 && i+1 < argc)
+        {
+            outFile = argv[++i];
+        }
+        else if (strcmp(argv[i],"-e") == 0)
+        {
+            format = GRAPH_FILE_EDGES;
+        }
+        else if (strcmp(argv[i],"-b") == 0)
+        {
+            format = GRAPH_FILE_BINARY;
+        }
+        else
+        {
+            maxCycleSize = atoi(argv[i]);
+        }
+    }
 
-    if (argc > 1)
+    if (resumeFile != NULL && (useJohnson == 1 || useComponents == 1 || countOnly == 1 || outFile != NULL))
+    {
+        cerr << "--resume only works with cycleGenerator, not with -j, -c, -n or -w" << endl;
+        return 1;
+    }
+    if ((memoryLimitMB > 0 || spillDir != NULL) && (useJohnson == 1 || useComponents == 1 || countOnly == 1 || outFile != NULL))
     {
-        maxCycleSize = atoi(argv[1]);
+        cerr << "-m and -d only work with cycleGenerator, not with -j, -c, -n or -w" << endl;
+        return 1;
     }
 
-    for (int i=0;i<numNodes;i++)
+    csrGraph graph;
+    int formatRead = GRAPH_FILE_MATRIX;
+    if (resumeFile == NULL && readGraph(inFile,graph,format,0,&formatRead) == 0)
     {
-        for (int j=0;j<numNodes;j++)
+        cerr << "Could not read a graph from " << (inFile == NULL ? "standard input" : inFile) << endl;
+        return 1;
+    }
+    if (outFile != NULL)
+    {
+        if (writeGraph(outFile,graph) == 0)
         {
-            cin >> adjMat[i][j];
+            cerr << "Could not write " << outFile << endl;
+            return 1;
         }
+        return 0;
     }
     //printMat(adjMat,numNodes);
 
@@ -75,27 +239,170 @@ int main (int argc, char *argv[])
     //    cout << endl;
     //}
 
-    cycleGenerator myCycleGen(adjMat,numNodes);
-    // Only save uniq cycles. That is, only print bi-directed cycles once
-    myCycleGen.setHashBiDirectedCycles(1);
-    myCycleGen.setCycleLengthMin(2);
-    myCycleGen.print();
+    if (countOnly == 1)
+    {
+        vector <long long> counts = countCyclesByLength(graph,maxCycleSize);
+        for (int k=2;k<counts.size();k++)
+        {
+            cout << k << " " << counts[k] << endl;
+        }
+        return 0;
+    }
+
+    if (useJohnson == 1)
+    {
+        johnsonCycleGenerator myJohnsonGen(graph);
+        myJohnsonGen.setHashBiDirectedCycles(1);
+        myJohnsonGen.setCycleLengthMin(2);
+        myJohnsonGen.setCycleLengthMax(maxCycleSize);
+        if (formatRead == GRAPH_FILE_MATRIX)
+        {
+            myJohnsonGen.print();
+        }
+        while (myJohnsonGen.findCycle() == 1)
+        {
+            const vector <int> &myCycle = myJohnsonGen.currentCycle();
+            for (int k=0;k<myCycle.size();k++)
+            {
+                cout << myCycle[k] << " ";
+            }
+            cout << endl;
+        }
+        return 0;
+    }
+
+    if (useComponents == 1)
+    {
+        sccCycleGenerator mySccGen(graph);
+        mySccGen.setHashBiDirectedCycles(1);
+        mySccGen.setCycleLengthMin(2);
+        mySccGen.setCycleLengthMax(maxCycleSize);
+        mySccGen.setNumThreads(numThreads);
+        if (formatRead == GRAPH_FILE_MATRIX)
+        {
+            mySccGen.print();
+        }
+        list <int> myCycle = mySccGen.nextCycle();
+        while (myCycle.size() != 0 && (myCycle.size() <= maxCycleSize || maxCycleSize == -1))
+        {
+            printListInt(myCycle);
+            myCycle = mySccGen.nextCycle();
+        }
+        return 0;
+    }
+
+    cycleGenerator myCycleGen;
+    myCycleGen.setNumThreads(numThreads);
+    if (memoryLimitMB > 0 && myCycleGen.setMemoryLimit((size_t)(memoryLimitMB*1048576),spillDir) == 0)
+    {
+        cerr << "Can not make files in " << (spillDir == NULL ? "/tmp" : spillDir) << endl;
+        return 1;
+    }
+    long long resumedCycles = 0;
+    if (resumeFile != NULL)
+    {
+        if (myCycleGen.load(resumeFile) == 0)
+        {
+            cerr << "Could not read a checkpoint from " << resumeFile << endl;
+            return 1;
+        }
+        resumedCycles = myCycleGen.getStats().cyclesReturned;
+        cerr << "Resuming after " << resumedCycles << " cycles" << endl;
+    }
+    else
+    {
+        myCycleGen.copyGraph(graph);
+        // Only save uniq cycles. That is, only print bi-directed cycles once
+        myCycleGen.setHashBiDirectedCycles(1);
+        myCycleGen.setCycleLengthMin(2);
+        myCycleGen.setCycleLengthMax(maxCycleSize);
+    }
+
+    long long checkpointCycles = -1; // The cycles printed when this run last wrote the checkpoint.
+    if (checkpointFile != NULL)
+    {
+        // The time is looked at every few thousand paths. Every cycle returned so far
+        // has been printed (and flushed by endl) when the callback runs.
+        chrono::steady_clock::time_point lastCheckpoint = chrono::steady_clock::now();
+        long long nextProgress = progressSteps;
+        myCycleGen.setProgressCallback([&](const cycleGeneratorStats &stats)
+        {
+            if (progressSteps > 0 && stats.steps >= nextProgress)
+            {
+                printProgress(stats);
+                nextProgress = stats.steps + progressSteps;
+            }
+            chrono::steady_clock::time_point now = chrono::steady_clock::now();
+            if (chrono::duration <double> (now - lastCheckpoint).count() >= checkpointSeconds)
+            {
+                if (myCycleGen.save(checkpointFile) == 0)
+                {
+                    cerr << "Could not write the checkpoint " << checkpointFile << endl;
+                }
+                else
+                {
+                    checkpointCycles = stats.cyclesReturned;
+                }
+                lastCheckpoint = now;
+            }
+        }, progressSteps > 0 ? min(progressSteps,4096LL) : 4096);
+    }
+    else if (progressSteps > 0)
+    {
+        myCycleGen.setProgressCallback(printProgress,progressSteps);
+    }
+
     list <int> myCycle;
+    // A sparse graph printed as a matrix could take far longer than finding its cycles.
+    if (resumeFile == NULL && formatRead == GRAPH_FILE_MATRIX)
+    {
+        myCycleGen.print();
+    }
     myCycle = myCycleGen.nextCycle(); 
-    do
-    {
-        printListInt(myCycle);
-        //cout << "isCycleBiDirected(myCycle) = " << myCycleGen.isCycleBiDirected(myCycle) << endl;
-        //cout << "revCycle: ";
-        //list <int> reversedList = revList(myCycle);
-        //printListInt(reversedList);
-        //cout << "Unique cycle rep: "; 
-        //list <int> uniqCycle = myCycleGen.uniqueBiDirCycle(myCycle);
-        //printListInt(uniqCycle);
-
-        //cout << listToString(myCycle) << endl;
-        myCycle = myCycleGen.nextCycle(); 
-    } while (myCycle.size() != 0 && (myCycle.size() <= maxCycleSize || maxCycleSize == -1));
+    // A first empty line is only printed when there are no cycles at all, not at
+    // the end of a resumed run.
+    if (myCycle.size() != 0 || resumedCycles == 0)
+    {
+        do
+        {
+            printListInt(myCycle);
+            //cout << "isCycleBiDirected(myCycle) = " << myCycleGen.isCycleBiDirected(myCycle) << endl;
+            //cout << "revCycle: ";
+            //list <int> reversedList = revList(myCycle);
+            //printListInt(reversedList);
+            //cout << "Unique cycle rep: "; 
+            //list <int> uniqCycle = myCycleGen.uniqueBiDirCycle(myCycle);
+            //printListInt(uniqCycle);
+
+            //cout << listToString(myCycle) << endl;
+            myCycle = myCycleGen.nextCycle(); 
+        } while (myCycle.size() != 0 && (myCycle.size() <= maxCycleSize || maxCycleSize == -1));
+    }
+    if (myCycleGen.spillError() == 1)
+    {
+        cerr << "Could not write or read the path queue files" << endl;
+        if (checkpointCycles != -1)
+        {
+            cerr << "The checkpoint " << checkpointFile << " is from after " << checkpointCycles << " cycles" << endl;
+        }
+        return 1;
+    }
+    if (checkpointFile != NULL)
+    {
+        // Every cycle has been printed, so there is nothing left to resume.
+        remove(checkpointFile);
+    }
+    if (printStats == 1)
+    {
+        cycleGeneratorStats stats = myCycleGen.getStats();
+        printProgress(stats);
+        cerr << "length cycles seconds" << endl;
+        for (int k=1;k<max(stats.cyclesByLength.size(),stats.secondsByLength.size());k++)
+        {
+            cerr << k << " " << (k < stats.cyclesByLength.size() ? stats.cyclesByLength[k] : 0);
+            cerr << " " << (k < stats.secondsByLength.size() ? stats.secondsByLength[k] : 0) << endl;
+        }
+    }
     //cout << "oneStep function called " << myCycleGen.numOneStepCall() << " times." << endl;
     //cout << "sizeUniqBiDirectedCycles() = "  << myCycleGen.sizeUniqBiDirectedCycles() << endl; 
 
@@ -115,6 +422,4 @@ int main (int argc, char *argv[])
     //{
     //    printListInt(*llit);
     //}
-
-    deleteAdjMat(adjMat,numNodes);
 }